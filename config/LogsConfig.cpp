@@ -0,0 +1,660 @@
+// LogsConfig.cpp
+
+#include "LogsConfig.hpp"
+#include <algorithm>
+#include <cctype>
+#include <csignal>
+#include <fcntl.h>
+#include <optional>
+#include <poll.h>
+#include <simple_logs/ContentFilter.hpp>
+#include <simple_logs/IsolatedBackend.hpp>
+#include <simple_logs/NamedLogger.hpp>
+#include <simple_logs/RequestContext.hpp>
+#include <sys/inotify.h>
+#include <syslog/SyslogBackend.hpp>
+#include <unistd.h>
+
+namespace logs {
+namespace {
+using Section = std::map<std::string, std::string>;
+
+std::string trim(std::string_view str) {
+  const char *spaces = " \t\r\n";
+  std::size_t begin  = str.find_first_not_of(spaces);
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  std::size_t end = str.find_last_not_of(spaces);
+  return std::string{str.substr(begin, end - begin + 1)};
+}
+
+std::string toLower(std::string str) {
+  std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) {
+    return std::tolower(c);
+  });
+  return str;
+}
+
+Severity toSeverity(const std::string &str) noexcept(false) {
+  static const std::map<std::string, Severity> severities{
+      {"trace", Severity::Trace},
+      {"debug", Severity::Debug},
+      {"info", Severity::Info},
+      {"warning", Severity::Warning},
+      {"throw", Severity::Throw},
+      {"error", Severity::Error},
+      {"failure", Severity::Failure}};
+
+  auto found = severities.find(toLower(str));
+  if (found == severities.end()) {
+    throw std::invalid_argument{"unknown severity: " + str};
+  }
+  return found->second;
+}
+
+SyslogBackend::Priority toSyslogPriority(const std::string &str) noexcept(
+    false) {
+  static const std::map<std::string, SyslogBackend::Priority> priorities{
+      {"emerg", SyslogBackend::Priority::Emerg},
+      {"alert", SyslogBackend::Priority::Alert},
+      {"crit", SyslogBackend::Priority::Crit},
+      {"err", SyslogBackend::Priority::Err},
+      {"warning", SyslogBackend::Priority::Warning},
+      {"notice", SyslogBackend::Priority::Notice},
+      {"info", SyslogBackend::Priority::Info},
+      {"debug", SyslogBackend::Priority::Debug}};
+
+  auto found = priorities.find(toLower(str));
+  if (found == priorities.end()) {
+    throw std::invalid_argument{"unknown syslog priority: " + str};
+  }
+  return found->second;
+}
+
+std::size_t toSize(const std::string &str) noexcept(false) {
+  std::size_t pos  = 0;
+  std::size_t size = std::stoull(str, &pos);
+  std::string unit = toLower(trim(std::string_view{str}.substr(pos)));
+  if (unit.empty()) {
+    return size;
+  } else if (unit == "k") {
+    return size << 10;
+  } else if (unit == "m") {
+    return size << 20;
+  } else if (unit == "g") {
+    return size << 30;
+  }
+  throw std::invalid_argument{"invalid size: " + str};
+}
+
+/**\return layout for CustomFrontend
+ */
+std::string toLayout(std::string format) noexcept(false) {
+  // `%` is written as is, so it is escaped before substitution of items
+  for (std::size_t pos = format.find('%'); pos != std::string::npos;
+       pos             = format.find('%', pos + 2)) {
+    format.insert(pos, 1, '%');
+  }
+
+  static const std::pair<std::string_view, std::string_view> items[]{
+      {"{severity}", SEVERITY},
+      {"{file}", FILE_NAME},
+      {"{line}", LINE_NUMBER},
+      {"{function}", FUNCTION_NAME},
+      {"{time}", TIME_POINT},
+      {"{thread}", THREAD_ID},
+      {"{message}", MESSAGE}};
+
+  for (const auto &[item, replacement] : items) {
+    for (std::size_t pos = format.find(item); pos != std::string::npos;
+         pos             = format.find(item, pos + replacement.size())) {
+      format.replace(pos, item.size(), replacement);
+    }
+  }
+  return format;
+}
+
+/**\return names of channels, which are separated by comma, excluded
+ * channels have prefix `!`
+ */
+std::vector<std::string> toChannelNames(const std::string &str) noexcept(
+    false) {
+  std::vector<std::string> names;
+  for (std::size_t begin = 0; begin <= str.size();) {
+    std::size_t end  = std::min(str.find(',', begin), str.size());
+    std::string name = trim(std::string_view{str}.substr(begin, end - begin));
+    begin            = end + 1;
+    if (name.empty() || name == "!") {
+      throw std::invalid_argument{"invalid channels: " + str};
+    }
+    names.emplace_back(std::move(name));
+  }
+  return names;
+}
+
+/**\return mask of the channels, which are registered if it is needed.
+ * Channels with `!` are excluded, if there are only excluded channels, then
+ * all other channels are included
+ */
+Channels toChannels(const std::vector<std::string> &names) noexcept(false) {
+  Channels included = 0;
+  Channels excluded = 0;
+  for (const std::string &name : names) {
+    if (name.front() == '!') {
+      excluded |= getChannel(trim(std::string_view{name}.substr(1)));
+    } else {
+      included |= getChannel(name);
+    }
+  }
+  return (included != 0 ? included : allChannels) & ~excluded;
+}
+
+/**\return not empty items, which are separated by comma
+ */
+std::vector<std::string> toList(const std::string &str) {
+  std::vector<std::string> items;
+  for (std::size_t begin = 0; begin < str.size();) {
+    std::size_t end  = std::min(str.find(',', begin), str.size());
+    std::string item = trim(std::string_view{str}.substr(begin, end - begin));
+    begin            = end + 1;
+    if (item.empty() == false) {
+      items.emplace_back(std::move(item));
+    }
+  }
+  return items;
+}
+
+std::string getValue(const Section &section, const std::string &key) {
+  auto found = section.find(key);
+  return found != section.end() ? found->second : std::string{};
+}
+
+void checkKeys(const Section                          &section,
+               std::initializer_list<std::string_view> keys) noexcept(false) {
+  for (const auto &[key, value] : section) {
+    if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+      throw std::invalid_argument{"unknown key: " + key};
+    }
+  }
+}
+
+bool toBool(const std::string &str) noexcept(false) {
+  std::string value = toLower(str);
+  if (value == "true" || value == "yes" || value == "on" || value == "1") {
+    return true;
+  } else if (value == "false" || value == "no" || value == "off" ||
+             value == "0") {
+    return false;
+  }
+  throw std::invalid_argument{"invalid boolean: " + str};
+}
+
+/**\return settings of asynchronous mode or nothing, if it is disabled
+ */
+std::optional<AsyncSettings> makeAsyncSettings(const Section &section) noexcept(
+    false) {
+  checkKeys(section,
+            {"enabled",
+             "urgent_level",
+             "batch_size",
+             "batch_delay",
+             "keep_order",
+             "synchronous_level",
+             "fan_out_threads"});
+
+  std::string enabled = getValue(section, "enabled");
+  if (enabled.empty() || toBool(enabled) == false) {
+    return std::nullopt;
+  }
+
+  AsyncSettings settings;
+  if (std::string value = getValue(section, "urgent_level"); !value.empty()) {
+    settings.urgentSeverity = toSeverity(value);
+  }
+  if (std::string value = getValue(section, "batch_size"); !value.empty()) {
+    settings.batchSize = std::max<std::size_t>(toSize(value), 1);
+  }
+  if (std::string value = getValue(section, "batch_delay"); !value.empty()) {
+    settings.batchDelay = std::chrono::milliseconds{std::stoll(value)};
+  }
+  if (std::string value = getValue(section, "keep_order"); !value.empty()) {
+    settings.keepOrder = toBool(value);
+  }
+  if (std::string value = getValue(section, "synchronous_level");
+      !value.empty()) {
+    settings.synchronous = Severity::Placeholder >= toSeverity(value);
+  }
+  if (std::string value = getValue(section, "fan_out_threads");
+      !value.empty()) {
+    settings.fanOutThreads = toSize(value);
+  }
+  return settings;
+}
+
+/**\brief validated settings of frontend of sink
+ */
+struct FrontendSettings {
+  /// layout of custom frontend, if it is empty, then type is used
+  std::string                          layout;
+  std::string                          type;
+  std::optional<Severity>              level;
+  std::vector<std::string>             channels;
+  std::shared_ptr<const ContentFilter> contentFilter;
+};
+
+/**\brief validated settings of backend of sink
+ */
+struct BackendSettings {
+  /// settings as string, backends with same settings are reused
+  std::string                      key;
+  std::string                      type;
+  std::string                      path;
+  std::size_t                      rotateSize  = 0;
+  std::size_t                      rotateCount = 1;
+  std::string                      ident;
+  SyslogBackend::Priority          priority = SyslogBackend::Priority::Info;
+  /// settings of IsolatedBackend, if the backend is isolated
+  std::optional<IsolationSettings> isolation;
+};
+
+struct SinkSettings {
+  std::string      name;
+  FrontendSettings frontend;
+  BackendSettings  backend;
+};
+
+FrontendSettings makeFrontendSettings(const Section &section) noexcept(false) {
+  FrontendSettings settings;
+  if (std::string format = getValue(section, "format"); format.empty()) {
+    settings.type = getValue(section, "frontend");
+    if (settings.type.empty()) {
+      settings.type = "standard";
+    } else if (settings.type != "standard" && settings.type != "light") {
+      throw std::invalid_argument{"unknown frontend: " + settings.type};
+    }
+  } else {
+    settings.layout = toLayout(std::move(format));
+  }
+
+  if (std::string level = getValue(section, "level"); level.empty() == false) {
+    settings.level = toSeverity(level);
+  }
+  if (std::string channels = getValue(section, "channels");
+      channels.empty() == false) {
+    settings.channels = toChannelNames(channels);
+  }
+
+  ContentFilterSettings content{toList(getValue(section, "files")),
+                                toList(getValue(section, "functions")),
+                                toList(getValue(section, "contains")),
+                                {}};
+  if (std::string regex = getValue(section, "matches");
+      regex.empty() == false) {
+    content.regexes.emplace_back(std::move(regex));
+  }
+  if (content.files.empty() == false || content.functions.empty() == false ||
+      content.substrings.empty() == false || content.regexes.empty() == false) {
+    settings.contentFilter =
+        std::make_shared<ContentFilter>(std::move(content));
+  }
+  return settings;
+}
+
+BackendSettings makeBackendSettings(const Section &section) noexcept(false) {
+  BackendSettings settings;
+  settings.type = getValue(section, "backend");
+  for (const char *item : {"path",
+                            "rotate_size",
+                            "rotate_count",
+                            "ident",
+                            "priority",
+                            "isolated",
+                            "max_latency"}) {
+    settings.key += '|';
+    settings.key += getValue(section, item);
+  }
+  settings.key.insert(0, settings.type);
+
+  if (settings.type == "file") {
+    settings.path = getValue(section, "path");
+    if (settings.path.empty()) {
+      throw std::invalid_argument{"path for file backend is not set"};
+    }
+    if (std::string value = getValue(section, "rotate_size"); !value.empty()) {
+      settings.rotateSize = toSize(value);
+    }
+    if (std::string value = getValue(section, "rotate_count"); !value.empty()) {
+      settings.rotateCount = toSize(value);
+    }
+  } else if (settings.type == "syslog") {
+    settings.ident = getValue(section, "ident");
+    if (std::string value = getValue(section, "priority"); !value.empty()) {
+      settings.priority = toSyslogPriority(value);
+    }
+  } else if (settings.type != "stdout" && settings.type != "stderr") {
+    throw std::invalid_argument{"unknown backend: " + settings.type};
+  }
+
+  if (std::string isolated = getValue(section, "isolated");
+      isolated.empty() == false && toBool(isolated)) {
+    IsolationSettings &isolation = settings.isolation.emplace();
+    if (std::string value = getValue(section, "max_latency"); !value.empty()) {
+      isolation.maxLatency = std::chrono::milliseconds{std::stoll(value)};
+    }
+  }
+  return settings;
+}
+
+SinkSettings makeSinkSettings(std::string    name,
+                              const Section &section) noexcept(false) {
+  checkKeys(section,
+            {"frontend",
+             "format",
+             "level",
+             "channels",
+             "files",
+             "functions",
+             "contains",
+             "matches",
+             "backend",
+             "path",
+             "rotate_size",
+             "rotate_count",
+             "ident",
+             "priority",
+             "isolated",
+             "max_latency"});
+
+  return SinkSettings{std::move(name),
+                      makeFrontendSettings(section),
+                      makeBackendSettings(section)};
+}
+
+/**\note the frontend isn't used by logger yet, so setting of its filters
+ * doesn't change logger
+ */
+std::shared_ptr<BasicFrontend>
+makeFrontend(const FrontendSettings &settings) noexcept(false) {
+  std::shared_ptr<BasicFrontend> frontend;
+  if (settings.layout.empty() == false) {
+    frontend = std::make_shared<CustomFrontend>(settings.layout);
+  } else if (settings.type == "light") {
+    frontend = std::make_shared<LightFrontend>();
+  } else {
+    frontend = std::make_shared<StandardFrontend>();
+  }
+
+  if (settings.level) {
+    frontend->setFilter(Severity::Placeholder >= *settings.level);
+  }
+  if (settings.channels.empty() == false) {
+    frontend->setChannels(toChannels(settings.channels));
+  }
+  frontend->setContentFilter(settings.contentFilter);
+  return frontend;
+}
+
+std::shared_ptr<BasicBackend>
+makeBackend(const BackendSettings &settings) noexcept(false) {
+  std::shared_ptr<BasicBackend> backend;
+  if (settings.type == "stdout") {
+    backend = std::make_shared<TextStreamBackend>(std::cout);
+  } else if (settings.type == "stderr") {
+    backend = std::make_shared<TextStreamBackend>(std::cerr);
+  } else if (settings.type == "file") {
+    backend = std::make_shared<FileBackend>(settings.path,
+                                            settings.rotateSize,
+                                            settings.rotateCount);
+  } else if (settings.ident.empty()) {
+    backend = std::make_shared<SyslogBackend>(settings.priority);
+  } else {
+    backend =
+        std::make_shared<SyslogBackend>(settings.ident, settings.priority);
+  }
+
+  if (settings.isolation) {
+    backend = std::make_shared<IsolatedBackend>(std::move(backend),
+                                                *settings.isolation);
+  }
+  return backend;
+}
+
+SamplingSettings makeSamplingSettings(const Section &section) noexcept(false) {
+  checkKeys(section, {"rate", "level"});
+
+  SamplingSettings settings;
+  if (std::string value = getValue(section, "rate"); !value.empty()) {
+    settings.rate = std::stod(value);
+    if ((settings.rate >= 0 && settings.rate <= 1) == false) {
+      throw std::invalid_argument{"invalid rate: " + value};
+    }
+  }
+  if (std::string value = getValue(section, "level"); !value.empty()) {
+    settings.severity = toSeverity(value);
+  }
+  return settings;
+}
+
+/**\brief pipe for notification about SIGHUP
+ */
+std::atomic_int hangupFd{-1};
+
+void hangupHandler(int) {
+  int fd = hangupFd.load();
+  if (fd != -1) {
+    char command = 'r';
+    [[maybe_unused]] ssize_t ignore = write(fd, &command, 1);
+  }
+}
+} // namespace
+
+void ConfigLoader::load(const std::string &fileName) noexcept(false) {
+  std::ifstream file{fileName};
+  if (file.is_open() == false) {
+    throw std::runtime_error{"can not open logs configuration: " + fileName};
+  }
+
+  // parse file
+  std::map<std::string, Severity, std::less<>> levels;
+  std::list<std::pair<std::string, Section>>   sinkSections;
+  Section                                      asyncSection;
+  Section                                      samplingSection;
+  Section                                     *section  = nullptr;
+  bool                                         isLevels = false;
+
+  std::string line;
+  for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+    try {
+      line = trim(line);
+      if (line.empty() || line[0] == '#' || line[0] == ';') {
+        continue;
+      }
+
+      if (line.front() == '[' && line.back() == ']') {
+        std::string name =
+            trim(std::string_view{line}.substr(1, line.size() - 2));
+        isLevels = name == "levels";
+        section  = nullptr;
+        if (name == "async") {
+          section = &asyncSection;
+        } else if (name == "sampling") {
+          section = &samplingSection;
+        } else if (name.compare(0, 5, "sink ") == 0) {
+          section = &sinkSections.emplace_back(trim(name.substr(5)), Section{})
+                         .second;
+        } else if (isLevels == false) {
+          throw std::invalid_argument{"unknown section: " + name};
+        }
+        continue;
+      }
+
+      std::size_t pos = line.find('=');
+      if (pos == std::string::npos) {
+        throw std::invalid_argument{"expected key = value"};
+      }
+      std::string key   = trim(std::string_view{line}.substr(0, pos));
+      std::string value = trim(std::string_view{line}.substr(pos + 1));
+
+      if (isLevels) {
+        levels[key == "root" ? std::string{} : key] = toSeverity(value);
+      } else if (section != nullptr) {
+        (*section)[toLower(key)] = value;
+      } else {
+        throw std::invalid_argument{"key out of section"};
+      }
+    } catch (std::exception &e) {
+      throw std::runtime_error{fileName + ':' + std::to_string(lineNumber) +
+                               ": " + e.what()};
+    }
+  }
+
+  std::optional<AsyncSettings> asyncSettings;
+  try {
+    asyncSettings = makeAsyncSettings(asyncSection);
+  } catch (std::exception &e) {
+    throw std::runtime_error{fileName + ": async: " + e.what()};
+  }
+
+  SamplingSettings samplingSettings;
+  try {
+    samplingSettings = makeSamplingSettings(samplingSection);
+  } catch (std::exception &e) {
+    throw std::runtime_error{fileName + ": sampling: " + e.what()};
+  }
+
+  std::vector<SinkSettings> sinkSettings;
+  for (const auto &[name, sinkSection] : sinkSections) {
+    try {
+      sinkSettings.emplace_back(makeSinkSettings(name, sinkSection));
+    } catch (std::exception &e) {
+      throw std::runtime_error{fileName + ": sink " + name + ": " + e.what()};
+    }
+  }
+
+  // whole file is valid, so sinks are created. Backends, which are used by
+  // current configuration, are reused, files are opened only for new ones
+  std::map<std::string, std::shared_ptr<BasicBackend>> backends;
+  SimpleLogger::SinkList                               sinks;
+  for (const SinkSettings &settings : sinkSettings) {
+    try {
+      const std::string            &key = settings.backend.key;
+      std::shared_ptr<BasicBackend> backend;
+      if (auto found = backends.find(key); found != backends.end()) {
+        backend = found->second;
+      } else if (found = backends_.find(key); found != backends_.end()) {
+        backend = found->second;
+      } else {
+        backend = makeBackend(settings.backend);
+      }
+      backends[key] = backend;
+
+      sinks.emplace_back(
+          Sink{makeFrontend(settings.frontend), std::move(backend)});
+    } catch (std::exception &e) {
+      throw std::runtime_error{fileName + ": sink " + settings.name + ": " +
+                               e.what()};
+    }
+  }
+
+  // apply configuration. Sinks and mode of logger are published at once, it
+  // is the only step, which can fail. Levels and sampling belong to other
+  // objects, so they are set right after it: records, which are logged at the
+  // moment, can be handled by new sinks with previous levels
+  SimpleLogger::get().configure(std::move(sinks), asyncSettings);
+  LoggerTree::get().setLevels(std::move(levels));
+  setSampling(samplingSettings);
+  backends_ = std::move(backends);
+}
+
+ConfigWatcher::ConfigWatcher(std::string fileName) noexcept(false)
+    : fileName_{std::move(fileName)}
+    , inotify_{-1}
+    , pipe_{-1, -1} {
+  loader_.load(fileName_);
+
+  if (pipe2(pipe_, O_CLOEXEC) == -1) {
+    throw std::runtime_error{"can not create pipe for config watcher"};
+  }
+
+  // watch the directory, because editors usually replace files
+  std::size_t slash = fileName_.rfind('/');
+  std::string directory =
+      slash == std::string::npos
+          ? std::string{"."}
+          : fileName_.substr(0, std::max<std::size_t>(slash, 1));
+  inotify_ = inotify_init1(IN_CLOEXEC);
+  if (inotify_ != -1) {
+    inotify_add_watch(inotify_,
+                      directory.c_str(),
+                      IN_CLOSE_WRITE | IN_MOVED_TO);
+  }
+
+  hangupFd.store(pipe_[1]);
+  std::signal(SIGHUP, hangupHandler);
+
+  thread_ = std::thread{&ConfigWatcher::watch, this};
+}
+
+ConfigWatcher::~ConfigWatcher() {
+  int expected = pipe_[1];
+  if (hangupFd.compare_exchange_strong(expected, -1)) {
+    std::signal(SIGHUP, SIG_DFL);
+  }
+
+  char command = 'q';
+  [[maybe_unused]] ssize_t ignore = write(pipe_[1], &command, 1);
+  thread_.join();
+
+  if (inotify_ != -1) {
+    close(inotify_);
+  }
+  close(pipe_[0]);
+  close(pipe_[1]);
+}
+
+void ConfigWatcher::reload() noexcept {
+  try {
+    loader_.load(fileName_);
+  } catch (std::exception &e) {
+    LOG_ERROR("can not reload logs configuration: %1%", e.what());
+  }
+}
+
+void ConfigWatcher::watch() noexcept {
+  std::string_view baseFileName = baseName(fileName_);
+
+  pollfd fds[2]{{pipe_[0], POLLIN, 0}, {inotify_, POLLIN, 0}};
+  for (;;) {
+    if (poll(fds, inotify_ != -1 ? 2 : 1, -1) == -1) {
+      continue;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      char command = 0;
+      if (read(pipe_[0], &command, 1) == 1 && command == 'q') {
+        return;
+      }
+      reload();
+    }
+
+    if (inotify_ != -1 && (fds[1].revents & POLLIN)) {
+      alignas(inotify_event) char buffer[4096];
+      ssize_t                     size = read(inotify_, buffer, sizeof(buffer));
+
+      bool changed = false;
+      for (ssize_t pos = 0; pos < size;) {
+        auto *event = reinterpret_cast<const inotify_event *>(buffer + pos);
+        if (event->len != 0 && baseFileName == event->name) {
+          changed = true;
+        }
+        pos += sizeof(inotify_event) + event->len;
+      }
+
+      if (changed) {
+        reload();
+      }
+    }
+  }
+}
+} // namespace logs
@@ -0,0 +1,147 @@
+// LogsConfig.hpp
+/**\file
+ * Configuration of logger from ini file, which can be changed without
+ * recompilation. Example of the file:
+ *
+ * ```ini
+ * # levels of named loggers, `root` is logger with empty name
+ * [levels]
+ * root    = info
+ * db      = debug
+ * db.pool = warning
+ *
+ * [sink console]
+ * frontend = light
+ * level    = debug
+ * channels = !db
+ * backend  = stdout
+ *
+ * [sink db]
+ * level    = debug
+ * channels = db
+ * backend  = file
+ * path     = /var/log/app/db.log
+ *
+ * # debug records only of database sources
+ * [sink db-debug]
+ * level   = debug
+ * files   = db_*.cpp
+ * backend = file
+ * path    = /var/log/app/db-debug.log
+ *
+ * [sink errors]
+ * format       = {severity} {time} {file}:{line} {function} | {message}
+ * level        = warning
+ * backend      = file
+ * path         = /var/log/app/errors.log
+ * rotate_size  = 10M
+ * rotate_count = 5
+ *
+ * [async]
+ * enabled      = true
+ * urgent_level = warning
+ * batch_size   = 256
+ * batch_delay  = 100
+ * # errors are written before returning from logging call
+ * synchronous_level = error
+ *
+ * # debug records are kept for 1% of requests
+ * [sampling]
+ * rate  = 0.01
+ * level = debug
+ * ```
+ *
+ * Keys of sink section:
+ *
+ * - `frontend` - `standard` (by default) or `light`
+ * - `format` - layout for custom frontend, can contain items `{severity}`,
+ * `{file}`, `{line}`, `{function}`, `{time}`, `{thread}` and `{message}`,
+ * other text (including `%`) is written as is. If set, then `frontend` is
+ * ignored
+ * - `level` - minimal severity of records for the sink, `trace` by default
+ * - `channels` - channels of records for the sink separated by comma, all
+ * channels by default. Channel with `!` is excluded, if all listed channels
+ * are excluded, then other channels are included. Records logged without
+ * channel belong to channel `default`
+ * - `files` and `functions` - globs of source files and function names
+ * separated by comma (files are base names without `LOGS_SOURCE_ROOT`),
+ * `contains` - substrings of message separated by comma, `matches` - regular
+ * expression, which is searched in message. If some of them are set, then
+ * records are filtered also by content, \see ContentFilter
+ * - `backend` - `stdout`, `stderr`, `file` or `syslog`
+ * - `path`, `rotate_size` (bytes, can have suffix `K`, `M` or `G`) and
+ * `rotate_count` - settings of `file` backend
+ * - `ident` and `priority` - settings of `syslog` backend
+ * - `isolated` - if `true`, then backend works in own thread and is not used
+ * while it is slower than `max_latency` milliseconds, \see IsolatedBackend
+ *
+ * Keys of async section correspond to fields of `AsyncSettings`: `enabled`,
+ * `urgent_level`, `batch_size`, `batch_delay` (milliseconds), `keep_order`,
+ * `synchronous_level` (records with the severity or higher are written
+ * synchronously) and `fan_out_threads`. If the section is absent, then logger
+ * works synchronously
+ *
+ * Keys of sampling section correspond to fields of `SamplingSettings`: `rate`
+ * and `level`. If the section is absent, then records of all requests are
+ * kept, \see RequestContext.hpp
+ *
+ * Backends with same settings are not recreated at reloading, so records are
+ * not lost and files are not reopened
+ */
+
+#pragma once
+
+#include <map>
+#include <simple_logs/logs.hpp>
+
+namespace logs {
+class ConfigLoader {
+public:
+  /**\brief read the configuration file and apply it to `SimpleLogger` and
+   * `LoggerTree`. Whole file is parsed and validated before creating of
+   * sinks, so invalid file opens no files
+   * \throw exception if the file can not be read or it is invalid, or sinks
+   * can not be created. In this case current configuration of logger is not
+   * changed
+   * \note sinks and mode of logger are published at once by
+   * `SimpleLogger::configure`. Levels and sampling belong to other objects,
+   * they are set right after it, so records, which are logged at the moment,
+   * can be handled by new sinks with previous levels
+   */
+  void load(const std::string &fileName) noexcept(false);
+
+private:
+  /// backends of current configuration by their settings
+  std::map<std::string, std::shared_ptr<BasicBackend>> backends_;
+};
+
+/**\brief load configuration and reload it after changing of the file or
+ * getting `SIGHUP`
+ * \note only one watcher can handle `SIGHUP` at the same time
+ */
+class ConfigWatcher {
+public:
+  /**\throw exception if configuration can not be loaded
+   */
+  explicit ConfigWatcher(std::string fileName) noexcept(false);
+  ~ConfigWatcher();
+
+  /**\brief load configuration again. Errors are logged by current
+   * configuration
+   */
+  void reload() noexcept;
+
+private:
+  ConfigWatcher(const ConfigWatcher &) = delete;
+  ConfigWatcher(ConfigWatcher &&)      = delete;
+
+  void watch() noexcept;
+
+private:
+  std::string  fileName_;
+  ConfigLoader loader_;
+  int          inotify_;
+  int          pipe_[2];
+  std::thread  thread_;
+};
+} // namespace logs
@@ -1,7 +1,31 @@
 // main.cpp
 
+#include "simple_logs/Batch.hpp"
+#include "simple_logs/Deadline.hpp"
+#include "simple_logs/NamedLogger.hpp"
+#include "simple_logs/RequestBuffer.hpp"
+#include "simple_logs/RequestContext.hpp"
+#include "simple_logs/SignalLog.hpp"
 #include "simple_logs/logs.hpp"
+#include <csignal>
 #include <cstdlib>
+#include <thread>
+
+struct Point {
+  int x;
+  int y;
+};
+
+template <>
+struct logs::formatter<Point> {
+  static void format(const Point &point, std::string &out) {
+    out += '(';
+    out += std::to_string(point.x);
+    out += ", ";
+    out += std::to_string(point.y);
+    out += ')';
+  }
+};
 
 int main(int argc, char *argv[]) {
   auto coutBackend   = std::make_shared<logs::TextStreamBackend>(std::cout);
@@ -22,6 +46,56 @@ int main(int argc, char *argv[]) {
   LOG_DEBUG("print only first argument: %1%; second argument never print",
             argc,
             argv);
+  logs::NamedLogger &dbLogger = NAMED_LOGGER("db.pool");
+  logs::LoggerTree::get().setLevel("db", logs::Severity::Info);
+  LOG_INFO_TO(dbLogger, "named logger: %1%", dbLogger.getName());
+  LOG_DEBUG_TO(dbLogger, "never print, because db level is Info");
+
+  errorFrontend->setChannels(logs::allChannels & ~logs::getChannel("db"));
+  LOG_WARNING_CH("db", "never print, because db channel is off for errors");
+  LOG_INFO_CH("db", "channel: %1%", "db");
+
+  {
+    logs::DeadlineScope deadline{std::chrono::milliseconds{0},
+                                 std::chrono::milliseconds{0}};
+    LOG_INFO("never print, because deadline is passed");
+  }
+
+  {
+    logs::setSampling(logs::SamplingSettings{0, logs::Severity::Debug});
+    logs::RequestContext context{"request-1"};
+    logs::RequestScope   scope{context};
+    LOG_DEBUG("never print, because request is not sampled");
+    LOG_INFO("request: %1%", context.getTraceId());
+
+    // context is moved to other thread with the request
+    logs::ContextCarrier carrier;
+    std::thread{carrier.wrap([]() {
+      LOG_DEBUG("never print, because request is not sampled");
+      LOG_INFO("request on other thread: %1%",
+               logs::RequestScope::current()->getTraceId());
+    })}.join();
+  }
+
+  {
+    logs::RequestBuffer buffer;
+    LOG_INFO("never print, because request is successful");
+  }
+
+  {
+    logs::RequestBuffer buffer;
+    LOG_DEBUG("request buffer: %1%", "printed, because request failed");
+    buffer.setFailed();
+  }
+
+  {
+    logs::Batch batch;
+    for (int i = 0; i < 3; ++i) {
+      LOG_INFO("batch item: %1%", i);
+    }
+  }
+
+  LOG_INFO("user type without operator<<: %1%", Point{argc, 2});
   LOG_WARNING("some warning without arguments %1%");
   LOG_ERROR("some error", "never print");
 
@@ -32,6 +106,13 @@ int main(int argc, char *argv[]) {
   } catch (std::runtime_error &) {
   }
 
+  // records of signal handlers are written by drain
+  std::signal(SIGUSR1, [](int signal) {
+    LOG_SIGNAL_SAFE(logs::Severity::Warning, "got signal: %1%", signal);
+  });
+  std::raise(SIGUSR1);
+  logs::SignalLog::get().drain();
+
   LOG_FAILURE("failure here even when logging switch off");
 
   std::cerr << "!!!never reachable!!!" << std::endl;
@@ -0,0 +1,40 @@
+// AppendStreamBuffer.hpp
+/**\file
+ * Stream buffer for printing directly to the end of string. It is used only
+ * by implementation of the library
+ */
+
+#pragma once
+
+#include <streambuf>
+
+namespace logs {
+namespace detail {
+/**\brief stream buffer, which appends all output to the string
+ * \tparam String std::string or RecordBuffer
+ */
+template <typename String>
+class AppendStreamBuffer final : public std::streambuf {
+public:
+  void setOutput(String *output) noexcept {
+    output_ = output;
+  }
+
+protected:
+  int_type overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof()) == false) {
+      output_->push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *data, std::streamsize size) override {
+    output_->append(data, static_cast<std::size_t>(size));
+    return size;
+  }
+
+private:
+  String *output_ = nullptr;
+};
+} // namespace detail
+} // namespace logs
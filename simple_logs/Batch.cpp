@@ -0,0 +1,61 @@
+// Batch.cpp
+
+#include "Batch.hpp"
+#include <algorithm>
+
+namespace logs {
+namespace {
+/// innermost batch of current thread
+thread_local Batch *currentBatch = nullptr;
+} // namespace
+
+Batch::Batch(std::size_t maxRecords) noexcept
+    : maxRecords_{std::max<std::size_t>(maxRecords, 1)}
+    , threadId_{std::this_thread::get_id()}
+    , previous_{currentBatch} {
+  records_.reserve(std::min<std::size_t>(maxRecords_, 1024));
+  currentBatch = this;
+}
+
+Batch::~Batch() {
+  currentBatch = previous_;
+  commit();
+}
+
+void Batch::commit() noexcept {
+  if (records_.empty() == false) {
+    LOGGER.log(records_);
+  }
+}
+
+void Batch::add(CallSite     &site,
+                Severity      severity,
+                boost::format message) noexcept {
+  RecordOrigin origin{std::chrono::system_clock::now(), threadId_};
+  if (LOGGER.isSynchronous(severity)) {
+    // collected records are queued first, then the record is written by
+    // current thread before returning, as without the batch
+    commit();
+    LOGGER.log(site, severity, std::move(message), origin);
+    return;
+  }
+
+  records_.push_back(AsyncRecord{0,
+                                 severity,
+                                 site.fileName,
+                                 site.lineNumber,
+                                 site.functionName,
+                                 origin,
+                                 &site,
+                                 std::move(message)});
+
+  if (records_.size() >= maxRecords_ ||
+      static_cast<int>(severity) == static_cast<int>(Severity::Failure)) {
+    commit();
+  }
+}
+
+Batch *Batch::current() noexcept {
+  return currentBatch;
+}
+} // namespace logs
@@ -0,0 +1,74 @@
+// Batch.hpp
+/**\file
+ * Explicit batches of records for tight loops:
+ *
+ * ```cpp
+ * logs::Batch batch;
+ * for (const Item &item : items) {
+ *   LOG_INFO("item: %1%", item.id);
+ * }
+ * ```
+ *
+ * Records, which are logged by current thread while batch exists, are
+ * collected and passed to logger at once at end of the batch. Sinks filter
+ * them by one pass, and every backend gets all its records by one call (\see
+ * BasicBackend::consumeBatch), so it is locked and flushed only once. In
+ * asynchronous mode records are queued by one lock.
+ *
+ * Messages are formatted at logging and records keep time of logging, but
+ * they are written only at commit, so records of other threads can be written
+ * between them. Record with severity `Failure` commits the batch immediately,
+ * because program is finished after it. Record, which must be written
+ * synchronously in asynchronous mode (\see AsyncSettings::synchronous),
+ * bypasses the batch after commit of previous records
+ */
+
+#pragma once
+
+#include <simple_logs/logs.hpp>
+#include <vector>
+
+namespace logs {
+/**\brief collects records of current thread until end of scope
+ *
+ * Batches can be nested, records are collected by the innermost batch
+ */
+class Batch {
+public:
+  /**\param maxRecords collected records are committed, when their count
+   * reaches it
+   */
+  explicit Batch(std::size_t maxRecords = 1024) noexcept;
+
+  /**\brief commit collected records
+   */
+  ~Batch();
+
+  Batch(const Batch &) = delete;
+  Batch(Batch &&)      = delete;
+
+  /**\return count of collected records
+   */
+  std::size_t getSize() const noexcept {
+    return records_.size();
+  }
+
+  /**\brief pass collected records to logger
+   */
+  void commit() noexcept;
+
+  /**\brief called by logging macroses after formatting of message
+   */
+  void add(CallSite &site, Severity severity, boost::format message) noexcept;
+
+  /**\return batch of current thread, or nullptr
+   */
+  static Batch *current() noexcept;
+
+private:
+  std::size_t              maxRecords_;
+  std::thread::id          threadId_;
+  std::vector<AsyncRecord> records_;
+  Batch                   *previous_;
+};
+} // namespace logs
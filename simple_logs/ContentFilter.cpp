@@ -0,0 +1,186 @@
+// ContentFilter.cpp
+
+#include "ContentFilter.hpp"
+#include <algorithm>
+#include <deque>
+
+namespace logs {
+namespace detail {
+/**\brief result of source filter for the call site
+ */
+struct FilterCache {
+  std::uint64_t filterId;
+  bool          accepted;
+  FilterCache  *next;
+};
+} // namespace detail
+
+namespace {
+/**\return true if the text matches the glob, `*` matches any characters and
+ * `?` matches one character
+ */
+bool matchGlob(std::string_view glob, std::string_view text) noexcept {
+  std::size_t g    = 0;
+  std::size_t t    = 0;
+  std::size_t star = std::string_view::npos;
+  std::size_t mark = 0;
+  while (t < text.size()) {
+    if (g < glob.size() && (glob[g] == '?' || glob[g] == text[t])) {
+      ++g;
+      ++t;
+    } else if (g < glob.size() && glob[g] == '*') {
+      star = g++;
+      mark = t;
+    } else if (star != std::string_view::npos) {
+      // the last star takes one more character
+      g = star + 1;
+      t = ++mark;
+    } else {
+      return false;
+    }
+  }
+  while (g < glob.size() && glob[g] == '*') {
+    ++g;
+  }
+  return g == glob.size();
+}
+
+bool matchAny(const std::vector<std::string> &globs,
+              std::string_view                text) noexcept {
+  return globs.empty() ||
+         std::any_of(globs.begin(), globs.end(), [text](const auto &glob) {
+           return matchGlob(glob, text);
+         });
+}
+} // namespace
+
+ContentFilter::ContentFilter(ContentFilterSettings settings) noexcept(false)
+    : settings_{std::move(settings)}
+    , id_{0}
+    , hasMessagePatterns_{settings_.substrings.empty() == false ||
+                          settings_.regexes.empty() == false}
+    , transitions_(1)
+    , found_(1, false) {
+  // cache keeps only result of source patterns
+  std::string key;
+  for (const auto *globs : {&settings_.files, &settings_.functions}) {
+    for (const std::string &glob : *globs) {
+      key += glob;
+      key += '\0';
+    }
+    key += '\1';
+  }
+  id_ = detail::internKey(key);
+
+  // trie of substrings, 0 means absence of transition while it is built
+  for (const std::string &substring : settings_.substrings) {
+    std::uint32_t state = 0;
+    for (unsigned char c : substring) {
+      if (transitions_[state][c] == 0) {
+        transitions_[state][c] = transitions_.size();
+        transitions_.emplace_back();
+        found_.push_back(false);
+      }
+      state = transitions_[state][c];
+    }
+    found_[state] = true;
+  }
+
+  // transitions of the trie are completed by suffix links in order of depth,
+  // so matching is one transition for every byte
+  std::vector<std::uint32_t> links(transitions_.size(), 0);
+  std::deque<std::uint32_t>  states;
+  for (std::uint32_t next : transitions_[0]) {
+    if (next != 0) {
+      states.push_back(next);
+    }
+  }
+  while (states.empty() == false) {
+    std::uint32_t state = states.front();
+    states.pop_front();
+    found_[state] = found_[state] || found_[links[state]];
+
+    for (std::size_t c = 0; c < 256; ++c) {
+      std::uint32_t &next = transitions_[state][c];
+      if (next != 0) {
+        links[next] = transitions_[links[state]][c];
+        states.push_back(next);
+      } else {
+        next = transitions_[links[state]][c];
+      }
+    }
+  }
+
+  if (settings_.regexes.empty() == false) {
+    std::string expression;
+    for (const std::string &regex : settings_.regexes) {
+      if (expression.empty() == false) {
+        expression += '|';
+      }
+      expression += "(?:" + regex + ')';
+    }
+    regex_.assign(expression, std::regex::ECMAScript | std::regex::optimize);
+  }
+}
+
+bool ContentFilter::isAccepted(CallSite            *site,
+                               std::string_view     fileName,
+                               std::string_view     functionName,
+                               const boost::format &message) const noexcept {
+  if (site == nullptr) {
+    if (isSourceAccepted(fileName, functionName) == false) {
+      return false;
+    }
+  } else {
+    detail::FilterCache *head =
+        site->filterCaches.load(std::memory_order_acquire);
+    detail::FilterCache *cache = head;
+    for (; cache != nullptr && cache->filterId != id_; cache = cache->next) {
+    }
+
+    if (cache == nullptr) {
+      // never deleted, because call sites are static, and count of caches is
+      // limited by count of different source patterns. If several threads
+      // create cache at same time, then all of them are added with same value
+      cache = new detail::FilterCache{
+          id_, isSourceAccepted(fileName, functionName), head};
+      while (site->filterCaches.compare_exchange_weak(
+                 cache->next,
+                 cache,
+                 std::memory_order_release,
+                 std::memory_order_acquire) == false) {
+      }
+    }
+    if (cache->accepted == false) {
+      return false;
+    }
+  }
+
+  return hasMessagePatterns_ == false || isMessageAccepted(recordText(message));
+}
+
+bool ContentFilter::isSourceAccepted(
+    std::string_view fileName,
+    std::string_view functionName) const noexcept {
+  return matchAny(settings_.files, fileName) &&
+         matchAny(settings_.functions, functionName);
+}
+
+bool ContentFilter::isMessageAccepted(std::string_view message) const noexcept {
+  if (settings_.substrings.empty() == false) {
+    std::uint32_t state = 0;
+    if (found_[state]) {
+      return true;
+    }
+    for (unsigned char c : message) {
+      state = transitions_[state][c];
+      if (found_[state]) {
+        return true;
+      }
+    }
+  }
+
+  return settings_.regexes.empty() == false &&
+         std::regex_search(message.begin(), message.end(), regex_);
+}
+} // namespace logs
@@ -0,0 +1,89 @@
+// ContentFilter.hpp
+/**\file
+ * Filter of records by their source and message, which is set for frontend in
+ * addition to filter of severities:
+ *
+ * ```cpp
+ * auto frontend = std::make_shared<logs::LightFrontend>();
+ * frontend->setFilter(logs::Severity::Placeholder >= logs::Severity::Debug);
+ * frontend->setContentFilter(std::make_shared<logs::ContentFilter>(
+ *     logs::ContentFilterSettings{{"db_*.cpp"}, {}, {}, {}}));
+ * ```
+ *
+ * Source of record is checked only once for every call site, result is kept
+ * in the call site. Message is rendered once for all sinks of the record (\see
+ * recordText). Substrings of message are searched by one pass of
+ * Aho-Corasick automaton, and regular expressions are combined to one
+ * expression, so only message of accepted source is checked for every record
+ */
+
+#pragma once
+
+#include <array>
+#include <regex>
+#include <simple_logs/logs.hpp>
+#include <string>
+#include <vector>
+
+namespace logs {
+/**\brief patterns of ContentFilter. Empty list accepts all records, otherwise
+ * record must match some pattern of the list
+ */
+struct ContentFilterSettings {
+  /// globs of source file names (\see sourceFileName), `*` matches any
+  /// characters (including `/`), `?` matches one character
+  /// \note file names are base names, if `LOGS_SOURCE_ROOT` isn't defined
+  /// (cmake option `logs_source_root`), so globs with directories match
+  /// nothing in this case
+  std::vector<std::string> files;
+
+  /// globs of function names
+  /// \note if `LOGS_HASH_FUNCTION_NAMES` defined, then names are hashes
+  std::vector<std::string> functions;
+
+  /// message of record is accepted, if it contains some substring, or matches
+  /// some regular expression
+  std::vector<std::string> substrings;
+
+  /// ECMAScript regular expressions, which are searched in message
+  std::vector<std::string> regexes;
+};
+
+/**\brief filter of records by file, function and message
+ */
+class ContentFilter {
+public:
+  /**\throw exception if some regular expression is invalid
+   */
+  explicit ContentFilter(ContentFilterSettings settings) noexcept(false);
+
+  const ContentFilterSettings &getSettings() const noexcept {
+    return settings_;
+  }
+
+  /**\param site can be nullptr, then source is checked without cache
+   */
+  bool isAccepted(CallSite            *site,
+                  std::string_view     fileName,
+                  std::string_view     functionName,
+                  const boost::format &message) const noexcept;
+
+private:
+  bool isSourceAccepted(std::string_view fileName,
+                        std::string_view functionName) const noexcept;
+
+  bool isMessageAccepted(std::string_view message) const noexcept;
+
+  ContentFilterSettings settings_;
+  /// id of source patterns, so filters with same patterns share caches
+  std::uint64_t         id_;
+  bool                  hasMessagePatterns_;
+
+  /// transitions of Aho-Corasick automaton by every byte, state 0 is initial
+  std::vector<std::array<std::uint32_t, 256>> transitions_;
+  /// true for states, where some substring is found
+  std::vector<bool>                           found_;
+  /// all regular expressions as alternatives of one expression
+  std::regex                                  regex_;
+};
+} // namespace logs
@@ -0,0 +1,74 @@
+// Deadline.cpp
+
+#include "Deadline.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace logs {
+namespace {
+/// innermost deadline scope of current thread
+thread_local DeadlineScope *currentDeadline = nullptr;
+
+std::atomic_uint64_t totalShed{0};
+} // namespace
+
+DeadlineScope::DeadlineScope(Clock::duration budget,
+                             Clock::duration reserve,
+                             Severity        keptSeverity) noexcept
+    : DeadlineScope{Clock::now() + budget, reserve, keptSeverity} {
+}
+
+DeadlineScope::DeadlineScope(Clock::time_point deadline,
+                             Clock::duration   reserve,
+                             Severity          keptSeverity) noexcept
+    : threshold_{deadline - reserve}
+    , keptSeverity_{keptSeverity}
+    , shedding_{false}
+    , shed_{0}
+    , previous_{currentDeadline} {
+  if (previous_ != nullptr) {
+    threshold_ = std::min(threshold_, previous_->threshold_);
+    shedding_  = previous_->shedding_;
+  }
+  currentDeadline = this;
+}
+
+DeadlineScope::~DeadlineScope() {
+  currentDeadline = previous_;
+  if (previous_ != nullptr) {
+    previous_->shed_ += shed_;
+  }
+}
+
+std::uint64_t DeadlineScope::getTotalShed() noexcept {
+  return totalShed.load(std::memory_order_relaxed);
+}
+
+DeadlineScope *DeadlineScope::current() noexcept {
+  return currentDeadline;
+}
+
+void DeadlineScope::setCurrent(DeadlineScope *scope) noexcept {
+  currentDeadline = scope;
+}
+
+bool DeadlineScope::shedRecord(Severity severity) noexcept {
+  DeadlineScope *scope = currentDeadline;
+  if (scope == nullptr ||
+      static_cast<int>(severity) >= static_cast<int>(scope->keptSeverity_)) {
+    return false;
+  }
+
+  // time is monotonic, so clock isn't read after the deadline
+  if (scope->shedding_ == false) {
+    if (Clock::now() < scope->threshold_) {
+      return false;
+    }
+    scope->shedding_ = true;
+  }
+
+  ++scope->shed_;
+  totalShed.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+} // namespace logs
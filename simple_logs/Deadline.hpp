@@ -0,0 +1,96 @@
+// Deadline.hpp
+/**\file
+ * Shedding of records under latency budget. Thread declares deadline of
+ * current unit of work by scope:
+ *
+ * ```cpp
+ * void handle(const Request &request) {
+ *   logs::DeadlineScope deadline{std::chrono::milliseconds{50},
+ *                                std::chrono::milliseconds{10}};
+ *   LOG_DEBUG("request: %1%", request.id);
+ * }
+ * ```
+ *
+ * When less than reserve remains until deadline, records with severity lower
+ * than `Warning` are dropped and counted. Records are checked before
+ * formatting of message, so dropped record costs only reading of clock, and
+ * after the first dropped record it costs nothing. Trace of workload
+ * (\see TraceRecorder) still contains dropped records. Scope of coroutine,
+ * which is resumed by other threads, must be carried by
+ * ContextCarrier::withScopes
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <simple_logs/LogsFront.hpp>
+
+namespace logs {
+/**\brief deadline of current unit of work of the thread
+ *
+ * Scopes can be nested, inner scope can make deadline only earlier. Count of
+ * records, which were dropped in inner scope, is added to outer scope
+ */
+class DeadlineScope {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**\param budget time for the unit of work from now
+   * \param reserve records are dropped, when remaining time is less than it
+   * \param keptSeverity records with the severity or higher are never dropped
+   */
+  DeadlineScope(Clock::duration budget,
+                Clock::duration reserve,
+                Severity        keptSeverity = Severity::Warning) noexcept;
+
+  DeadlineScope(Clock::time_point deadline,
+                Clock::duration   reserve,
+                Severity          keptSeverity = Severity::Warning) noexcept;
+
+  ~DeadlineScope();
+
+  DeadlineScope(const DeadlineScope &) = delete;
+  DeadlineScope(DeadlineScope &&)      = delete;
+
+  /**\return true if records are dropped already
+   */
+  bool isShedding() const noexcept {
+    return shedding_;
+  }
+
+  /**\return count of records, which were dropped in the scope
+   */
+  std::uint64_t getShed() const noexcept {
+    return shed_;
+  }
+
+  /**\return count of records, which were dropped by all scopes
+   */
+  static std::uint64_t getTotalShed() noexcept;
+
+  /**\brief called by logging macroses before formatting of message
+   * \return true if record must be dropped by deadline of current thread, in
+   * this case it is counted
+   */
+  static bool shedRecord(Severity severity) noexcept;
+
+  /**\return innermost scope of current thread, or nullptr
+   */
+  static DeadlineScope *current() noexcept;
+
+private:
+  friend class ContextCarrier;
+
+  /**\brief set innermost scope of current thread \see ContextCarrier
+   */
+  static void setCurrent(DeadlineScope *scope) noexcept;
+
+  /// records are dropped after the time
+  Clock::time_point threshold_;
+  Severity          keptSeverity_;
+  bool              shedding_;
+  std::uint64_t     shed_;
+  DeadlineScope    *previous_;
+};
+} // namespace logs
@@ -0,0 +1,244 @@
+// IsolatedBackend.cpp
+
+#include "IsolatedBackend.hpp"
+#include <deque>
+
+namespace logs {
+namespace {
+using Clock = std::chrono::steady_clock;
+} // namespace
+
+struct IsolatedBackend::State {
+  State(std::shared_ptr<BasicBackend> wrapped,
+        IsolationSettings             isolation) noexcept
+      : backend{std::move(wrapped)}
+      , settings{isolation}
+      , degraded{false}
+      , busySince{0}
+      , dropped{0}
+      , flushRequested{false}
+      , stopped{false}
+      , finished{false} {
+  }
+
+  /**\return true if current writing takes too much time
+   */
+  bool isStalled() const noexcept;
+
+  /**\return false if writing took too much time
+   */
+  bool write(std::string_view record) noexcept;
+
+  void run() noexcept;
+
+  void process(std::unique_lock<std::mutex> &lock) noexcept;
+
+  std::shared_ptr<BasicBackend> backend;
+  IsolationSettings             settings;
+  std::atomic_bool              degraded;
+  /// time of starting current writing, or 0 if backend is idle
+  std::atomic_int64_t           busySince;
+  std::atomic_uint64_t          dropped;
+
+  std::mutex              mutex;
+  std::condition_variable cv;
+  std::deque<std::string> queue;
+  /// last record, which was logged in degraded state
+  std::string             probe;
+  bool                    flushRequested;
+  bool                    stopped;
+  /// true when writer thread finished
+  bool                    finished;
+  std::condition_variable finishedCv;
+
+  /// locked by writer thread while it uses the backend
+  std::timed_mutex writeMutex;
+};
+
+bool IsolatedBackend::State::isStalled() const noexcept {
+  std::int64_t since = busySince.load(std::memory_order_relaxed);
+  return since != 0 &&
+         Clock::now().time_since_epoch().count() - since >
+             std::chrono::duration_cast<Clock::duration>(settings.maxLatency)
+                 .count();
+}
+
+bool IsolatedBackend::State::write(std::string_view record) noexcept {
+  Clock::time_point start = Clock::now();
+  busySince.store(start.time_since_epoch().count(), std::memory_order_relaxed);
+  {
+    std::lock_guard<std::timed_mutex> lock{writeMutex};
+    backend->consume(record);
+  }
+  busySince.store(0, std::memory_order_relaxed);
+  return Clock::now() - start <= settings.maxLatency;
+}
+
+void IsolatedBackend::State::run() noexcept {
+  std::unique_lock<std::mutex> lock{mutex};
+  process(lock);
+  finished = true;
+  finishedCv.notify_one();
+}
+
+void IsolatedBackend::State::process(
+    std::unique_lock<std::mutex> &lock) noexcept {
+  std::deque<std::string> records;
+  for (;;) {
+    if (degraded.load(std::memory_order_relaxed)) {
+      cv.wait_for(lock, settings.probeInterval, [this]() {
+        return stopped;
+      });
+      if (stopped) {
+        return;
+      }
+      if (probe.empty()) {
+        continue;
+      }
+
+      std::string record = std::move(probe);
+      probe.clear();
+      lock.unlock();
+      bool recovered = write(record);
+      lock.lock();
+      degraded.store(recovered == false, std::memory_order_relaxed);
+      continue;
+    }
+
+    cv.wait(lock, [this]() {
+      return queue.empty() == false || flushRequested || stopped;
+    });
+    if (queue.empty() && stopped) {
+      return;
+    }
+
+    records.swap(queue);
+    bool needFlush = flushRequested;
+    flushRequested = false;
+    lock.unlock();
+
+    while (records.empty() == false) {
+      bool isFast = write(records.front());
+      records.pop_front();
+      if (isFast == false) {
+        degraded.store(true, std::memory_order_relaxed);
+        dropped.fetch_add(records.size(), std::memory_order_relaxed);
+        records.clear();
+      }
+    }
+    if (needFlush && degraded.load(std::memory_order_relaxed) == false) {
+      std::lock_guard<std::timed_mutex> writeLock{writeMutex};
+      backend->flush();
+    }
+
+    lock.lock();
+    if (degraded.load(std::memory_order_relaxed)) {
+      dropped.fetch_add(queue.size(), std::memory_order_relaxed);
+      queue.clear();
+    }
+  }
+}
+
+IsolatedBackend::IsolatedBackend(std::shared_ptr<BasicBackend> backend,
+                                 IsolationSettings settings) noexcept(false)
+    : state_{std::make_shared<State>(std::move(backend), settings)}
+    , backendLocked_{false} {
+  if (state_->backend == nullptr) {
+    throw std::invalid_argument{"invalid logger backend"};
+  }
+  thread_ = std::thread{&State::run, state_};
+}
+
+IsolatedBackend::~IsolatedBackend() {
+  std::unique_lock<std::mutex> lock{state_->mutex};
+  state_->stopped = true;
+  state_->cv.notify_one();
+  while (state_->finishedCv.wait_for(lock,
+                                     state_->settings.maxLatency,
+                                     [this]() {
+                                       return state_->finished;
+                                     }) == false) {
+    if (state_->isStalled()) {
+      // the thread keeps state until it finishes
+      thread_.detach();
+      return;
+    }
+  }
+  lock.unlock();
+  thread_.join();
+}
+
+void IsolatedBackend::consume(std::string_view record) noexcept {
+  State &state = *state_;
+  if (state.degraded.load(std::memory_order_relaxed) == false &&
+      state.isStalled()) {
+    state.degraded.store(true, std::memory_order_relaxed);
+  }
+
+  std::unique_lock<std::mutex> lock{state.mutex};
+  if (state.degraded.load(std::memory_order_relaxed)) {
+    if (state.probe.empty() == false) {
+      state.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    state.probe.assign(record.data(), record.size());
+    return;
+  }
+
+  if (state.queue.size() >= state.settings.queueSize) {
+    state.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  state.queue.emplace_back(record);
+
+  lock.unlock();
+  state.cv.notify_one();
+}
+
+void IsolatedBackend::flush() noexcept {
+  {
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    state_->flushRequested = true;
+  }
+  state_->cv.notify_one();
+}
+
+void IsolatedBackend::lockForFork() noexcept {
+  state_->mutex.lock();
+  backendLocked_ = state_->writeMutex.try_lock_for(state_->settings.maxLatency);
+  if (backendLocked_) {
+    state_->backend->lockForFork();
+  }
+}
+
+void IsolatedBackend::unlockAfterFork(bool child) noexcept {
+  State &state = *state_;
+  if (backendLocked_) {
+    state.backend->unlockAfterFork(child);
+    state.writeMutex.unlock();
+  }
+  if (child) {
+    if (backendLocked_ == false) {
+      reinitializeAfterFork(state.writeMutex);
+      state.degraded.store(true, std::memory_order_relaxed);
+    }
+    state.queue.clear();
+    state.probe.clear();
+    state.busySince.store(0, std::memory_order_relaxed);
+    state.flushRequested = false;
+    reinitializeAfterFork(state.cv);
+    reinitializeAfterFork(state.finishedCv);
+    reinitializeAfterFork(thread_);
+    thread_ = std::thread{&State::run, state_};
+  }
+  backendLocked_ = false;
+  state.mutex.unlock();
+}
+
+bool IsolatedBackend::isDegraded() const noexcept {
+  return state_->degraded.load(std::memory_order_relaxed);
+}
+
+std::uint64_t IsolatedBackend::getDropped() const noexcept {
+  return state_->dropped.load(std::memory_order_relaxed);
+}
+} // namespace logs
@@ -0,0 +1,91 @@
+// IsolatedBackend.hpp
+/**\file
+ * Backend, which protects logger from slow backends. Wrap backend, which can
+ * be blocked (syslog socket, file on network storage and etc.), before adding
+ * it to sink:
+ *
+ * ```cpp
+ * auto backend = std::make_shared<logs::IsolatedBackend>(
+ *     std::make_shared<logs::SyslogBackend>(logs::SyslogBackend::Priority::Info));
+ * LOGGER_ADD_SINK(frontend, backend);
+ * ```
+ */
+
+#pragma once
+
+#include <memory>
+#include <simple_logs/logs.hpp>
+#include <thread>
+
+namespace logs {
+struct IsolationSettings {
+  /// maximal count of records in queue, other records are dropped
+  std::size_t queueSize = 8192;
+
+  /// if writing of record takes more time, then backend is marked as degraded
+  std::chrono::milliseconds maxLatency{500};
+
+  /// interval between attempts to write record to degraded backend
+  std::chrono::milliseconds probeInterval{1000};
+};
+
+/**\brief write records to other backend in own thread
+ *
+ * If the backend is slower than `IsolationSettings::maxLatency`, then it
+ * marked as degraded and all records for it are dropped. Once per
+ * `IsolationSettings::probeInterval` last dropped record is written to the
+ * backend, and if it is fast enough, then the backend is not degraded anymore
+ */
+class IsolatedBackend final : public BasicBackend {
+public:
+  /**\throw exception if backend is invalid
+   */
+  explicit IsolatedBackend(std::shared_ptr<BasicBackend> backend,
+                           IsolationSettings settings = {}) noexcept(false);
+
+  /**\note waits until all queued records are written. If the backend is
+   * stalled, then writer thread is detached and finishes later, so the
+   * destructor never blocks longer than `IsolationSettings::maxLatency`
+   */
+  ~IsolatedBackend() override;
+
+  /**\note never blocks for writing, only for queueing
+   */
+  void consume(std::string_view record) noexcept override;
+
+  void flush() noexcept override;
+
+  /**\note waits for current record no more than
+   * `IsolationSettings::maxLatency`, so stalled backend doesn't block fork.
+   * The backend is locked for fork only if it isn't used by writer thread
+   */
+  void lockForFork() noexcept override;
+
+  /**\note in child process queued records of parent are dropped, and writer
+   * thread is started again. If writer of parent was stalled in the backend,
+   * then state of the backend is unknown, so it is degraded in child
+   */
+  void unlockAfterFork(bool child) noexcept override;
+
+  bool isDegraded() const noexcept;
+
+  /**\return count of dropped records
+   */
+  std::uint64_t getDropped() const noexcept;
+
+private:
+  /**\brief state, which is shared with writer thread, so detached thread can
+   * use it after destruction of the backend
+   */
+  struct State;
+
+  IsolatedBackend(const IsolatedBackend &) = delete;
+  IsolatedBackend(IsolatedBackend &&)      = delete;
+
+private:
+  std::shared_ptr<State> state_;
+  std::thread            thread_;
+  /// true if the backend is locked for fork
+  bool                   backendLocked_;
+};
+} // namespace logs
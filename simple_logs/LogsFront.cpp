@@ -0,0 +1,217 @@
+// LogsFront.cpp
+
+#include "LogsFront.hpp"
+#include "Batch.hpp"
+#include "Deadline.hpp"
+#include "Profiler.hpp"
+#include "RequestBuffer.hpp"
+#include "RequestContext.hpp"
+#include "Trace.hpp"
+#include "logs.hpp"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace logs {
+Channels getChannel(std::string_view name) noexcept(false) {
+  static std::mutex               mutex;
+  static std::vector<std::string> names{"default"};
+
+  std::lock_guard<std::mutex> lock{mutex};
+  auto found = std::find(names.begin(), names.end(), name);
+  if (found == names.end()) {
+    if (names.size() == 64) {
+      throw std::length_error{"too many channels, can not register channel " +
+                              std::string{name}};
+    }
+    found = names.emplace(names.end(), name);
+  }
+  return Channels{1} << (found - names.begin());
+}
+
+namespace detail {
+/**\brief adapter for passing type-erased argument to boost::format
+ */
+struct ArgumentRef {
+  const Argument &argument;
+};
+
+static std::ostream &operator<<(std::ostream &stream, ArgumentRef ref) {
+  ref.argument.print(stream, ref.argument.value);
+  return stream;
+}
+
+static boost::format makeMessage(std::string_view messageFormat,
+                                 const Argument  *arguments,
+                                 std::size_t      count) noexcept {
+  boost::format message = getLogFormat(messageFormat);
+  for (std::size_t i = 0; i < count; ++i) {
+    message % ArgumentRef{arguments[i]};
+  }
+  return message;
+}
+
+void printValue(std::ostream &stream, bool value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, char value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, signed char value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, unsigned char value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, short value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, unsigned short value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, int value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, unsigned int value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, long value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, unsigned long value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, long long value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, unsigned long long value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, float value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, double value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, long double value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, Severity value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, const void *value) {
+  stream << value;
+}
+
+void printValue(std::ostream &stream, std::string_view value) {
+  stream << value;
+}
+
+void printFormattedValue(std::ostream &stream,
+                         void (*format)(const void *value, std::string &out),
+                         const void *value) {
+  thread_local std::string buffer;
+
+  // the buffer is taken for the call, so formatter can log too
+  std::string text;
+  text.swap(buffer);
+  text.clear();
+  format(value, text);
+  printValue(stream, std::string_view{text});
+  text.swap(buffer);
+}
+
+/**\brief pass accepted record to the buffer, the batch or the logger
+ */
+static void logAccepted(CallSite        &site,
+                        Severity         severity,
+                        std::string_view messageFormat,
+                        const Argument  *arguments,
+                        std::size_t      count) noexcept {
+  if (RequestBuffer::keepRecord(site,
+                                severity,
+                                messageFormat,
+                                arguments,
+                                count) ||
+      RequestScope::dropRecord(severity) ||
+      DeadlineScope::shedRecord(severity)) {
+    return;
+  }
+
+  if (Batch *batch = Batch::current()) {
+    batch->add(site, severity, makeMessage(messageFormat, arguments, count));
+    return;
+  }
+
+  LOGGER.log(site, severity, makeMessage(messageFormat, arguments, count));
+}
+
+void logArguments(CallSite        &site,
+                  Severity         severity,
+                  std::string_view messageFormat,
+                  const Argument  *arguments,
+                  std::size_t      count) noexcept {
+  if (TraceRecorder::get().isRecording()) {
+    TraceRecorder::get().record(site,
+                                severity,
+                                messageFormat,
+                                arguments,
+                                count);
+  }
+
+  // checked before formatting, because it is the most expensive part
+  if (LOGGER.mayAccept(severity, site.channel) == false) {
+    return;
+  }
+
+  if (Profiler::get().isRunning() == false) {
+    logAccepted(site, severity, messageFormat, arguments, count);
+    return;
+  }
+
+  // records, which are kept by RequestBuffer or collected by Batch, are
+  // counted too, their cost is paid by the call
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  logAccepted(site, severity, messageFormat, arguments, count);
+  site.calls.fetch_add(1, std::memory_order_relaxed);
+  site.nanoseconds.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count(),
+      std::memory_order_relaxed);
+}
+
+std::string formatArguments(std::string_view messageFormat,
+                            const Argument  *arguments,
+                            std::size_t      count) noexcept {
+  return makeMessage(messageFormat, arguments, count).str();
+}
+
+std::uint64_t internKey(std::string_view key) noexcept(false) {
+  static std::mutex                                     mutex;
+  static std::unordered_map<std::string, std::uint64_t> ids;
+
+  std::lock_guard<std::mutex> lock{mutex};
+  return ids.emplace(std::string{key}, ids.size() + 1).first->second;
+}
+} // namespace detail
+} // namespace logs
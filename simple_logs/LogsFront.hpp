@@ -0,0 +1,613 @@
+// LogsFront.hpp
+/**\file
+ * Lightweight header for logging. It declares only severities and logging
+ * macroses, so it doesn't include boost::format, iostreams and threading
+ * headers. All formatting is done by compiled `simple_logs` library:
+ *
+ * ```cpp
+ * #include <simple_logs/LogsFront.hpp>
+ *
+ * LOG_DEBUG("connections: %1%", count);
+ * ```
+ *
+ * Use it in every file, which only writes logs. Sinks of logger must be set
+ * up with full header `simple_logs/logs.hpp`.
+ *
+ * Arguments of messages are passed to the library by pointers with printing
+ * functions. Arithmetic types, strings, pointers and types with specialized
+ * `logs::formatter` are printed by the library. Other types are printed by
+ * `operator<<(std::ostream &, const T &)`, so it must be declared before using
+ * them in log messages
+ *
+ * \note severity names (`TRACE_SEVERITY` etc.) and layouts of frontends are
+ * compiled in the library, so redefine them by compile definitions of
+ * `simple_logs` target, not before including the header
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#define TRACE_SEVERITY   "TRC"
+#define DEBUG_SEVERITY   "DBG"
+#define INFO_SEVERITY    "INF"
+#define WARNING_SEVERITY "WRN"
+#define THROW_SEVERITY   "THR"
+#define ERROR_SEVERITY   "ERR"
+#define FAILURE_SEVERITY "FLR"
+
+namespace logs {
+enum class Severity {
+  /// use in predicates
+  Placeholder,
+  Trace,
+  Debug,
+  Info,
+  Warning,
+  Throw,
+  Error,
+  Failure
+};
+
+inline std::string toString(Severity sev) {
+  switch (sev) {
+  case Severity::Trace:
+    return TRACE_SEVERITY;
+  case Severity::Debug:
+    return DEBUG_SEVERITY;
+  case Severity::Info:
+    return INFO_SEVERITY;
+  case Severity::Warning:
+    return WARNING_SEVERITY;
+  case Severity::Error:
+    return ERROR_SEVERITY;
+  case Severity::Failure:
+    return FAILURE_SEVERITY;
+  case Severity::Throw:
+    return THROW_SEVERITY;
+  default:
+    assert(false && "invalid severity");
+  }
+
+  return "";
+}
+
+/**\brief string computed at compile time, which stored in static memory
+ * without unused parts of its source
+ */
+template <std::size_t N>
+class StaticString {
+public:
+  constexpr explicit StaticString(std::string_view str) noexcept
+      : data_{} {
+    for (std::size_t i = 0; i < N && i < str.size(); ++i) {
+      data_[i] = str[i];
+    }
+  }
+
+  constexpr std::string_view view() const noexcept {
+    return std::string_view{data_, N};
+  }
+
+private:
+  char data_[N + 1];
+};
+
+/**\return file name without directories
+ */
+constexpr std::string_view baseName(std::string_view path) noexcept {
+  std::size_t pos = path.find_last_of("/\\");
+  if (pos == std::string_view::npos) {
+    return path;
+  }
+  return path.substr(pos + 1);
+}
+
+/**\return path relative to `LOGS_SOURCE_ROOT` if the path placed in it,
+ * otherwise file name without directories
+ */
+constexpr std::string_view sourceFileName(std::string_view path) noexcept {
+#ifdef LOGS_SOURCE_ROOT
+  constexpr std::string_view sourceRoot = LOGS_SOURCE_ROOT;
+  if (sourceRoot.empty() == false &&
+      path.substr(0, sourceRoot.size()) == sourceRoot) {
+    path.remove_prefix(sourceRoot.size());
+    while (path.empty() == false && (path[0] == '/' || path[0] == '\\')) {
+      path.remove_prefix(1);
+    }
+    return path;
+  }
+#endif
+  return baseName(path);
+}
+
+/**\brief FNV-1a hash, which can be calculated at compile time
+ */
+constexpr std::uint32_t hashName(std::string_view name) noexcept {
+  std::uint32_t hash = 2166136261u;
+  for (char c : name) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**\brief replacement for function name in form `#xxxxxxxx`
+ */
+template <std::uint32_t Hash>
+struct HashedName {
+  static constexpr StaticString<9> makeName() noexcept {
+    constexpr std::string_view digits = "0123456789abcdef";
+    char                       name[9]{'#'};
+    for (int i = 0; i < 8; ++i) {
+      name[8 - i] = digits[(Hash >> (i * 4)) & 0xf];
+    }
+    return StaticString<9>{std::string_view{name, 9}};
+  }
+
+  static constexpr StaticString<9> value = makeName();
+};
+
+/**\brief customization point for printing user types without iostreams
+ *
+ * Specialize it for your type and provide static function
+ * `void format(const T &value, std::string &out)`, which appends text
+ * representation of the value to `out`. If there is no such specialization,
+ * then `operator<<(std::ostream &, const T &)` is used as fallback.
+ *
+ * For deferred rendering (\see RequestBuffer) the specialization can also
+ * provide static function `capture(const T &value)`, which returns cheap copy
+ * of all data needed for printing the value later. Returned type must be
+ * printable by formatter or by `operator<<`
+ */
+template <typename T, typename = void>
+struct formatter {};
+
+/**\brief set of channels as bitmask, every registered channel has own bit
+ * \see getChannel
+ */
+using Channels = std::uint64_t;
+
+/// channel `default` of records, which are logged without channel
+constexpr Channels defaultChannel = 1;
+
+/// frontends accept all channels by default
+constexpr Channels allChannels = ~Channels{0};
+
+/**\return bit of channel with the name, the channel is registered at first
+ * call. At most 64 channels can be registered, including `default`
+ * \throw exception if there is no free bit for new channel
+ */
+Channels getChannel(std::string_view name) noexcept(false);
+
+namespace detail {
+struct FilterCache;
+struct LayoutCache;
+struct MetricsSlot;
+
+/**\return id of the key, equal keys always get same id. Caches in call sites
+ * are identified by ids of their keys, so objects with same settings share
+ * caches, and recreated objects (for example at reloading of configuration)
+ * don't add new ones
+ */
+std::uint64_t internKey(std::string_view key) noexcept(false);
+} // namespace detail
+
+/**\brief place in source code, where records are logged. Every logging
+ * macro has own static call site, which also holds counters of Profiler
+ * \note constructor registers the call site in Profiler, so call sites must
+ * have static storage duration
+ */
+struct CallSite {
+  CallSite(std::string_view file,
+           int              line,
+           std::string_view function,
+           Channels         recordChannel = defaultChannel) noexcept;
+
+  CallSite(const CallSite &) = delete;
+  CallSite(CallSite &&)      = delete;
+
+  std::string_view fileName;
+  int              lineNumber;
+  std::string_view functionName;
+  /// bit of channel of records
+  Channels         channel;
+
+  /// count of calls of logging macro
+  std::atomic_uint64_t calls;
+  /// count of records, which were accepted by some sink
+  std::atomic_uint64_t records;
+  /// total size of formatted records, which were consumed by backends
+  std::atomic_uint64_t bytes;
+  /// total time of formatting and writing records
+  std::atomic_uint64_t nanoseconds;
+
+  /// parts of records, which are same for all records of the call site,
+  /// rendered once for every layout \see Layout
+  std::atomic<detail::LayoutCache *> layoutCaches;
+
+  /// counters of records of the call site for every MetricsFrontend
+  std::atomic<detail::MetricsSlot *> metricsSlots;
+
+  /// results of source filters of ContentFilter for the call site
+  std::atomic<detail::FilterCache *> filterCaches;
+
+  /// next registered call site
+  CallSite *next;
+};
+
+namespace detail {
+template <typename T, typename = void>
+struct HasFormat : std::false_type {};
+
+template <typename T>
+struct HasFormat<
+    T,
+    std::void_t<decltype(formatter<T>::format(std::declval<const T &>(),
+                                              std::declval<std::string &>()))>>
+    : std::true_type {};
+
+template <typename T, typename = void>
+struct HasCapture : std::false_type {};
+
+template <typename T>
+struct HasCapture<
+    T,
+    std::void_t<decltype(formatter<T>::capture(std::declval<const T &>()))>>
+    : std::true_type {};
+
+/**\brief copy of argument, which is printed later
+ * \see formatter
+ */
+class CapturedArgument {
+public:
+  virtual ~CapturedArgument() = default;
+
+  virtual void print(std::ostream &stream) const = 0;
+};
+
+/**\brief how argument is printed, used for capturing of trace
+ * \see TraceRecorder
+ */
+enum class ArgumentKind : std::uint8_t {
+  Builtin,
+  Text,
+  Pointer,
+  Formatted,
+  Streamed,
+};
+
+/**\brief argument of log message with function for printing it
+ */
+struct Argument {
+  using Print   = void (*)(std::ostream &stream, const void *value);
+  using Capture = std::unique_ptr<CapturedArgument> (*)(const void *value);
+
+  const void  *value;
+  Print        print;
+  ArgumentKind kind;
+  /// nullptr if `formatter` of the type has no `capture`
+  Capture      capture = nullptr;
+};
+
+/// types, which are printed by the library
+template <typename T>
+struct IsBuiltin
+    : std::disjunction<std::is_same<T, bool>,
+                       std::is_same<T, char>,
+                       std::is_same<T, signed char>,
+                       std::is_same<T, unsigned char>,
+                       std::is_same<T, short>,
+                       std::is_same<T, unsigned short>,
+                       std::is_same<T, int>,
+                       std::is_same<T, unsigned int>,
+                       std::is_same<T, long>,
+                       std::is_same<T, unsigned long>,
+                       std::is_same<T, long long>,
+                       std::is_same<T, unsigned long long>,
+                       std::is_same<T, float>,
+                       std::is_same<T, double>,
+                       std::is_same<T, long double>,
+                       std::is_same<T, Severity>> {};
+
+void printValue(std::ostream &stream, bool value);
+void printValue(std::ostream &stream, char value);
+void printValue(std::ostream &stream, signed char value);
+void printValue(std::ostream &stream, unsigned char value);
+void printValue(std::ostream &stream, short value);
+void printValue(std::ostream &stream, unsigned short value);
+void printValue(std::ostream &stream, int value);
+void printValue(std::ostream &stream, unsigned int value);
+void printValue(std::ostream &stream, long value);
+void printValue(std::ostream &stream, unsigned long value);
+void printValue(std::ostream &stream, long long value);
+void printValue(std::ostream &stream, unsigned long long value);
+void printValue(std::ostream &stream, float value);
+void printValue(std::ostream &stream, double value);
+void printValue(std::ostream &stream, long double value);
+void printValue(std::ostream &stream, Severity value);
+void printValue(std::ostream &stream, const void *value);
+void printValue(std::ostream &stream, std::string_view value);
+
+template <typename T>
+void printBuiltin(std::ostream &stream, const void *value) {
+  printValue(stream, *static_cast<const T *>(value));
+}
+
+template <typename T>
+void printText(std::ostream &stream, const void *value) {
+  const T &text = *static_cast<const T *>(value);
+  if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+    if (text == nullptr) {
+      printValue(stream, static_cast<const void *>(nullptr));
+      return;
+    }
+  }
+  printValue(stream, std::string_view{text});
+}
+
+template <typename T>
+void printPointer(std::ostream &stream, const void *value) {
+  printValue(stream, static_cast<const void *>(*static_cast<const T *>(value)));
+}
+
+template <typename T>
+void formatValue(const void *value, std::string &out) {
+  formatter<T>::format(*static_cast<const T *>(value), out);
+}
+
+/**\brief print value by the function of formatter. Text is formatted to
+ * buffer of current thread, so its memory is reused by every call
+ */
+void printFormattedValue(std::ostream &stream,
+                         void (*format)(const void *value, std::string &out),
+                         const void *value);
+
+template <typename T>
+void printFormatted(std::ostream &stream, const void *value) {
+  printFormattedValue(stream, &formatValue<T>, value);
+}
+
+template <typename T>
+void printStreamed(std::ostream &stream, const void *value) {
+  stream << *static_cast<const T *>(value);
+}
+
+template <typename T>
+std::unique_ptr<CapturedArgument> captureValue(const void *value);
+
+/**\return argument without capturing
+ */
+template <typename T>
+Argument makePrintedArgument(const T &value) noexcept {
+  if constexpr (HasFormat<T>::value) {
+    return Argument{&value, &printFormatted<T>, ArgumentKind::Formatted};
+  } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+    return Argument{&value, &printText<T>, ArgumentKind::Text};
+  } else if constexpr (IsBuiltin<T>::value) {
+    return Argument{&value, &printBuiltin<T>, ArgumentKind::Builtin};
+  } else if constexpr (std::is_pointer_v<T> &&
+                       std::is_object_v<std::remove_pointer_t<T>>) {
+    return Argument{&value, &printPointer<T>, ArgumentKind::Pointer};
+  } else {
+    return Argument{&value, &printStreamed<T>, ArgumentKind::Streamed};
+  }
+}
+
+template <typename T>
+Argument makeArgument(const T &value) noexcept {
+  Argument argument = makePrintedArgument(value);
+  if constexpr (HasCapture<T>::value) {
+    argument.capture = &captureValue<T>;
+  }
+  return argument;
+}
+
+template <typename T>
+class CapturedValue final : public CapturedArgument {
+public:
+  explicit CapturedValue(T value)
+      : value_{std::move(value)} {
+  }
+
+  void print(std::ostream &stream) const override {
+    Argument argument = makeArgument(value_);
+    argument.print(stream, argument.value);
+  }
+
+private:
+  T value_;
+};
+
+template <typename T>
+std::unique_ptr<CapturedArgument> captureValue(const void *value) {
+  auto captured = formatter<T>::capture(*static_cast<const T *>(value));
+  return std::make_unique<CapturedValue<decltype(captured)>>(
+      std::move(captured));
+}
+
+/**\brief format message and send it to logger
+ * \param arguments array of `count` arguments
+ */
+void logArguments(CallSite        &site,
+                  Severity         severity,
+                  std::string_view messageFormat,
+                  const Argument  *arguments,
+                  std::size_t      count) noexcept;
+
+/**\return formatted message
+ */
+std::string formatArguments(std::string_view messageFormat,
+                            const Argument  *arguments,
+                            std::size_t      count) noexcept;
+
+/**\brief entry point of logging macroses
+ */
+template <typename... Args>
+void logMessage(CallSite        &site,
+                Severity         severity,
+                std::string_view messageFormat,
+                const Args &...args) noexcept {
+  // one more item, because array can not be empty
+  const Argument arguments[sizeof...(Args) + 1] = {
+      makeArgument(args)..., Argument{nullptr, nullptr, ArgumentKind::Builtin}};
+  logArguments(site, severity, messageFormat, arguments, sizeof...(Args));
+}
+
+template <typename... Args>
+std::string formatMessage(std::string_view messageFormat,
+                          const Args &...args) noexcept {
+  const Argument arguments[sizeof...(Args) + 1] = {
+      makeArgument(args)..., Argument{nullptr, nullptr, ArgumentKind::Builtin}};
+  return formatArguments(messageFormat, arguments, sizeof...(Args));
+}
+} // namespace detail
+} // namespace logs
+
+#ifndef LOGS_FILE_NAME
+/**\brief name of current source file, computed at compile time
+ * \see logs::sourceFileName
+ */
+#  define LOGS_FILE_NAME                                                       \
+    ([]() noexcept -> std::string_view {                                       \
+      static constexpr logs::StaticString<logs::sourceFileName(__FILE__)       \
+                                              .size()>                         \
+          fileName{logs::sourceFileName(__FILE__)};                            \
+      return fileName.view();                                                  \
+    }())
+#endif
+
+#ifndef LOGS_FUNCTION_NAME
+/**\brief name of current function. If `LOGS_HASH_FUNCTION_NAMES` defined,
+ * then function names replaced by its hashes, so they don't stored in binary
+ */
+#  ifdef LOGS_HASH_FUNCTION_NAMES
+#    define LOGS_FUNCTION_NAME                                                 \
+      logs::HashedName<logs::hashName(__func__)>::value.view()
+#  else
+#    define LOGS_FUNCTION_NAME __func__
+#  endif
+#endif
+
+#ifndef LOGS_CALL_SITE
+/**\brief static call site of current logging macro
+ * \see logs::CallSite
+ */
+#  define LOGS_CALL_SITE                                                       \
+    ([](std::string_view functionName) noexcept -> logs::CallSite & {          \
+      static logs::CallSite site{LOGS_FILE_NAME, __LINE__, functionName};      \
+      return site;                                                             \
+    }(LOGS_FUNCTION_NAME))
+#endif
+
+#ifndef LOGS_CHANNEL_CALL_SITE
+/**\brief static call site of current logging macro with the channel
+ * \param channel name of channel, it is registered at first call
+ */
+#  define LOGS_CHANNEL_CALL_SITE(channel)                                      \
+    ([](std::string_view functionName,                                         \
+        std::string_view channelName) noexcept -> logs::CallSite & {           \
+      static logs::CallSite site{LOGS_FILE_NAME,                               \
+                                 __LINE__,                                     \
+                                 functionName,                                 \
+                                 logs::getChannel(channelName)};               \
+      return site;                                                             \
+    }(LOGS_FUNCTION_NAME, channel))
+#endif
+
+#ifndef LOG_MESSAGE
+/**\brief log message with the severity, first argument is format of message
+ */
+#  define LOG_MESSAGE(severity, ...)                                           \
+    logs::detail::logMessage(LOGS_CALL_SITE, severity, __VA_ARGS__);
+#endif
+
+#ifndef LOG_TRACE
+#  define LOG_TRACE(...) LOG_MESSAGE(logs::Severity::Trace, __VA_ARGS__)
+#endif
+
+#ifndef LOG_DEBUG
+#  define LOG_DEBUG(...) LOG_MESSAGE(logs::Severity::Debug, __VA_ARGS__)
+#endif
+
+#ifndef LOG_INFO
+#  define LOG_INFO(...) LOG_MESSAGE(logs::Severity::Info, __VA_ARGS__)
+#endif
+
+#ifndef LOG_WARNING
+#  define LOG_WARNING(...) LOG_MESSAGE(logs::Severity::Warning, __VA_ARGS__)
+#endif
+
+#ifndef LOG_ERROR
+#  define LOG_ERROR(...) LOG_MESSAGE(logs::Severity::Error, __VA_ARGS__)
+#endif
+
+#ifndef LOG_CHANNEL_MESSAGE
+/**\brief log message to the channel, sinks can subscribe to channels by
+ * `BasicFrontend::setChannels`
+ * \param channel name of channel, for example `"db"`
+ * \warning program is terminated, if the channel is new and there are already
+ * 64 channels
+ */
+#  define LOG_CHANNEL_MESSAGE(channel, severity, ...)                          \
+    logs::detail::logMessage(                                                  \
+        LOGS_CHANNEL_CALL_SITE(channel), severity, __VA_ARGS__);
+#endif
+
+#ifndef LOG_TRACE_CH
+#  define LOG_TRACE_CH(channel, ...)                                           \
+    LOG_CHANNEL_MESSAGE(channel, logs::Severity::Trace, __VA_ARGS__)
+#endif
+
+#ifndef LOG_DEBUG_CH
+#  define LOG_DEBUG_CH(channel, ...)                                           \
+    LOG_CHANNEL_MESSAGE(channel, logs::Severity::Debug, __VA_ARGS__)
+#endif
+
+#ifndef LOG_INFO_CH
+#  define LOG_INFO_CH(channel, ...)                                            \
+    LOG_CHANNEL_MESSAGE(channel, logs::Severity::Info, __VA_ARGS__)
+#endif
+
+#ifndef LOG_WARNING_CH
+#  define LOG_WARNING_CH(channel, ...)                                         \
+    LOG_CHANNEL_MESSAGE(channel, logs::Severity::Warning, __VA_ARGS__)
+#endif
+
+#ifndef LOG_ERROR_CH
+#  define LOG_ERROR_CH(channel, ...)                                           \
+    LOG_CHANNEL_MESSAGE(channel, logs::Severity::Error, __VA_ARGS__)
+#endif
+
+#ifndef LOG_FAILURE
+/**\brief print log and terminate program
+ * \warning be careful with redefining! `LOG_FAILURE` must finish program,
+ * otherwise it can has unexpected behaviour
+ */
+#  define LOG_FAILURE(...)                                                     \
+    LOG_MESSAGE(logs::Severity::Failure, __VA_ARGS__);                         \
+    exit(EXIT_FAILURE)
+#endif
+
+#ifndef LOG_THROW
+/**\brief print log and generate specified exception
+ * \param ExceptionType type of generated exception
+ * \warning be careful with redefining! `LOG_THROW` must throw needed exception,
+ * otherwise it can has unexpected behaviour
+ */
+#  define LOG_THROW(ExceptionType, ...)                                        \
+    {                                                                          \
+      std::string logsThrowMessage =                                           \
+          logs::detail::formatMessage(__VA_ARGS__);                            \
+      LOG_MESSAGE(logs::Severity::Throw, "%1%", logsThrowMessage);             \
+      throw ExceptionType{logsThrowMessage};                                   \
+    }
+#endif
@@ -0,0 +1,293 @@
+// Metrics.cpp
+
+#include "Metrics.hpp"
+#include <array>
+#include <exception>
+#include <mutex>
+
+namespace logs {
+namespace {
+constexpr std::size_t severityCount = static_cast<int>(Severity::Failure) + 1;
+
+/**\brief id of destroyed frontend with its slots
+ */
+struct FreeSlots {
+  std::uint64_t        id;
+  detail::MetricsSlot *slots;
+};
+
+/**\brief ids of destroyed frontends are given to new ones with their slots,
+ * so rebuilding of sinks doesn't add slots to call sites
+ */
+class MetricsIds {
+public:
+  static MetricsIds &get() noexcept {
+    // never destroyed: frontends can be destroyed at exit
+    static MetricsIds *ids = new MetricsIds;
+    return *ids;
+  }
+
+  FreeSlots acquire() noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (free_.empty()) {
+      return FreeSlots{++lastId_, nullptr};
+    }
+    FreeSlots retval = free_.back();
+    free_.pop_back();
+    return retval;
+  }
+
+  void release(FreeSlots slots) noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    try {
+      free_.emplace_back(slots);
+    } catch (std::exception &) {
+      // the id and its slots are never used again
+    }
+  }
+
+private:
+  std::mutex             mutex_;
+  std::uint64_t          lastId_ = 0;
+  std::vector<FreeSlots> free_;
+};
+} // namespace
+
+namespace detail {
+/**\brief counters of records of the call site for one MetricsFrontend
+ */
+struct MetricsSlot {
+  MetricsSlot(std::uint64_t id, const CallSite *callSite) noexcept
+      : metricsId{id}
+      , site{callSite}
+      , counts{}
+      , nextOfSite{nullptr}
+      , nextOfMetrics{nullptr} {
+  }
+
+  std::uint64_t                                   metricsId;
+  const CallSite                                 *site;
+  /// counts of records of current window by severities
+  std::array<std::atomic_uint64_t, severityCount> counts;
+  std::mutex                                      messagesMutex;
+  std::array<std::string, severityCount>          firstMessages;
+  std::array<std::string, severityCount>          lastMessages;
+  /// next slot of the call site
+  MetricsSlot                                    *nextOfSite;
+  /// next slot of the frontend
+  MetricsSlot                                    *nextOfMetrics;
+};
+} // namespace detail
+
+MetricsFrontend::MetricsFrontend(std::chrono::system_clock::duration window,
+                                 bool keepLastMessage) noexcept
+    : window_{window}
+    , keepLastMessage_{keepLastMessage}
+    , id_{0}
+    , windowEnd_{0}
+    , slots_{nullptr}
+    , siteless_{std::make_unique<detail::MetricsSlot>(0, nullptr)} {
+  FreeSlots free = MetricsIds::get().acquire();
+  id_            = free.id;
+  slots_.store(free.slots, std::memory_order_relaxed);
+}
+
+MetricsFrontend::~MetricsFrontend() {
+  detail::MetricsSlot *slots = slots_.load(std::memory_order_acquire);
+  // counters of unfinished window must not be got by next frontend
+  for (detail::MetricsSlot *slot = slots; slot != nullptr;
+       slot                      = slot->nextOfMetrics) {
+    for (std::size_t i = 0; i < severityCount; ++i) {
+      slot->counts[i].store(0, std::memory_order_relaxed);
+      slot->firstMessages[i].clear();
+      slot->lastMessages[i].clear();
+    }
+  }
+  MetricsIds::get().release(FreeSlots{id_, slots});
+}
+
+std::string MetricsFrontend::makeRecord(
+    Severity         severity,
+    std::string_view fileName,
+    int              lineNumber,
+    std::string_view functionName,
+    boost::format    message) const noexcept {
+  RecordBuffer buffer;
+  formatRecord(buffer, severity, fileName, lineNumber, functionName, message);
+  return std::string{buffer};
+}
+
+void MetricsFrontend::formatRecord(
+    RecordBuffer        &buffer,
+    Severity             severity,
+    std::string_view,
+    int,
+    std::string_view,
+    const boost::format &message) const noexcept {
+  using Rep = std::chrono::system_clock::rep;
+
+  // the record, which finishes window, is counted in next window
+  Rep time = recordTime().time_since_epoch().count();
+  Rep end  = windowEnd_.load(std::memory_order_relaxed);
+  if (time >= end &&
+      windowEnd_.compare_exchange_strong(end,
+                                         time + window_.count(),
+                                         std::memory_order_relaxed) &&
+      end != 0) {
+    finishWindow(buffer);
+  }
+
+  detail::MetricsSlot &slot     = getSlot(recordSite());
+  std::size_t          index    = static_cast<int>(severity);
+  std::uint64_t        previous = slot.counts[index].fetch_add(
+      1, std::memory_order_relaxed);
+  if (previous != 0 && keepLastMessage_ == false) {
+    return;
+  }
+
+  std::string                 text{recordText(message)};
+  std::lock_guard<std::mutex> lock{slot.messagesMutex};
+  if (previous == 0 || slot.firstMessages[index].empty()) {
+    slot.firstMessages[index] = text;
+  }
+  if (keepLastMessage_) {
+    slot.lastMessages[index] = std::move(text);
+  }
+}
+
+void MetricsFrontend::formatPending(RecordBuffer &buffer,
+                                    bool          finish) const noexcept {
+  using Rep = std::chrono::system_clock::rep;
+
+  Rep end = windowEnd_.load(std::memory_order_relaxed);
+  if (end != 0 && (finish || recordTime().time_since_epoch().count() >= end) &&
+      windowEnd_.compare_exchange_strong(end, 0, std::memory_order_relaxed)) {
+    finishWindow(buffer);
+  }
+}
+
+std::vector<SiteMetrics> MetricsFrontend::getMetrics() const noexcept {
+  std::vector<SiteMetrics> metrics;
+  auto                     collect = [&metrics](detail::MetricsSlot &slot) {
+    for (std::size_t i = 0; i < severityCount; ++i) {
+      std::uint64_t count = slot.counts[i].load(std::memory_order_relaxed);
+      if (count == 0) {
+        continue;
+      }
+
+      std::lock_guard<std::mutex> lock{slot.messagesMutex};
+      metrics.push_back(SiteMetrics{slot.site,
+                                    static_cast<Severity>(i),
+                                    count,
+                                    slot.firstMessages[i],
+                                    slot.lastMessages[i]});
+    }
+  };
+
+  collect(*siteless_);
+  for (detail::MetricsSlot *slot = slots_.load(std::memory_order_acquire);
+       slot != nullptr;
+       slot = slot->nextOfMetrics) {
+    collect(*slot);
+  }
+  return metrics;
+}
+
+detail::MetricsSlot &MetricsFrontend::getSlot(CallSite *site) const noexcept {
+  if (site == nullptr) {
+    return *siteless_;
+  }
+
+  detail::MetricsSlot *head =
+      site->metricsSlots.load(std::memory_order_acquire);
+  for (detail::MetricsSlot *slot = head; slot != nullptr;
+       slot                      = slot->nextOfSite) {
+    if (slot->metricsId == id_) {
+      return *slot;
+    }
+  }
+
+  // never deleted, because call sites are static
+  auto *slot       = new detail::MetricsSlot{id_, site};
+  slot->nextOfSite = head;
+  while (site->metricsSlots.compare_exchange_weak(slot->nextOfSite,
+                                                  slot,
+                                                  std::memory_order_release,
+                                                  std::memory_order_acquire) ==
+         false) {
+    // other thread can add slot of the frontend at same time, and records
+    // must not be split between two slots
+    for (detail::MetricsSlot *other = slot->nextOfSite; other != head;
+         other                      = other->nextOfSite) {
+      if (other->metricsId == id_) {
+        delete slot;
+        return *other;
+      }
+    }
+    head = slot->nextOfSite;
+  }
+
+  slot->nextOfMetrics = slots_.load(std::memory_order_relaxed);
+  while (slots_.compare_exchange_weak(slot->nextOfMetrics,
+                                      slot,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed) == false) {
+  }
+  return *slot;
+}
+
+void MetricsFrontend::finishWindow(RecordBuffer &buffer) const noexcept {
+  auto        milliseconds =
+      std::chrono::duration_cast<std::chrono::milliseconds>(window_).count();
+  std::string duration = milliseconds % 1000 == 0
+                             ? std::to_string(milliseconds / 1000) + " s"
+                             : std::to_string(milliseconds) + " ms";
+  auto summarize = [this, &buffer, &duration](detail::MetricsSlot &slot) {
+    for (std::size_t i = 0; i < severityCount; ++i) {
+      std::uint64_t count =
+          slot.counts[i].exchange(0, std::memory_order_relaxed);
+      if (count == 0) {
+        continue;
+      }
+
+      std::string first;
+      std::string last;
+      {
+        std::lock_guard<std::mutex> lock{slot.messagesMutex};
+        first.swap(slot.firstMessages[i]);
+        last.swap(slot.lastMessages[i]);
+      }
+
+      if (buffer.empty() == false) {
+        buffer += '\n';
+      }
+      buffer += toString(static_cast<Severity>(i));
+      buffer += ' ';
+      if (slot.site != nullptr) {
+        buffer += slot.site->fileName;
+        buffer += ':';
+        buffer += std::to_string(slot.site->lineNumber);
+      } else {
+        buffer += "unknown";
+      }
+      buffer += " | ";
+      buffer += std::to_string(count);
+      buffer += " records in ";
+      buffer += duration;
+      buffer += ", first: ";
+      buffer += first;
+      if (keepLastMessage_) {
+        buffer += ", last: ";
+        buffer += last;
+      }
+    }
+  };
+
+  summarize(*siteless_);
+  for (detail::MetricsSlot *slot = slots_.load(std::memory_order_acquire);
+       slot != nullptr;
+       slot = slot->nextOfMetrics) {
+    summarize(*slot);
+  }
+}
+} // namespace logs
@@ -0,0 +1,118 @@
+// Metrics.hpp
+/**\file
+ * Metrics of records instead of records. MetricsFrontend counts records of
+ * every call site and severity in time windows, records aren't rendered by
+ * layout:
+ *
+ * ```cpp
+ * auto metrics =
+ *     std::make_shared<logs::MetricsFrontend>(std::chrono::seconds{60});
+ * metrics->setFilter(logs::Severity::Placeholder >= logs::Severity::Warning);
+ * LOGGER_ADD_SINK(metrics, backend);
+ * ```
+ *
+ * Counting of record is one atomic increment in counters of its call site,
+ * the record isn't rendered by layout. Arguments are still passed to message
+ * by logging macro, because other sinks can accept the record, but messages
+ * are formatted only for first record of every call site in window, and for
+ * every record if last messages are kept. When window
+ * is finished, summary of the window is passed to backend with next record,
+ * which is accepted by the frontend, or by `SimpleLogger::flush`, so it can
+ * be called periodically for quiet programs. Summary of current window is
+ * written at destruction of logger and when the sink is removed. Summary has
+ * one line for every call site and severity:
+ *
+ * ```
+ * WRN main.cpp:90 | 1234 records in 60 s, first: ..., last: ...
+ * ```
+ *
+ * Counters of current window can be exported as metrics by `getMetrics`
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <simple_logs/logs.hpp>
+#include <string>
+#include <vector>
+
+namespace logs {
+/**\brief records of the call site with the severity in current window
+ */
+struct SiteMetrics {
+  /// nullptr for records, which were logged without call site
+  const CallSite *site;
+  Severity        severity;
+  std::uint64_t   count;
+  std::string     firstMessage;
+  /// empty if last messages aren't kept
+  std::string     lastMessage;
+};
+
+/**\brief counts records by call sites and severities, backend of its sink
+ * gets only summaries of windows
+ * \note counters are kept in call sites, so they are never deleted, but they
+ * are reused by frontend, which is created after destruction of other one
+ */
+class MetricsFrontend final : public BasicFrontend {
+public:
+  /**\param window duration of window, it starts with first record after end
+   * of previous window
+   * \param keepLastMessage if true, then message of every record is formatted
+   * for keeping last message, otherwise other records are only counted
+   */
+  explicit MetricsFrontend(
+      std::chrono::system_clock::duration window = std::chrono::seconds{60},
+      bool keepLastMessage                       = false) noexcept;
+
+  ~MetricsFrontend() override;
+
+  /**\return summary of previous window if the record finishes it, otherwise
+   * empty string
+   */
+  std::string makeRecord(Severity         severity,
+                         std::string_view fileName,
+                         int              lineNumber,
+                         std::string_view functionName,
+                         boost::format    message) const noexcept override;
+
+  /**\brief count the record, if it finishes window, then summary of the
+   * window is appended to the buffer
+   */
+  void formatRecord(RecordBuffer        &buffer,
+                    Severity             severity,
+                    std::string_view     fileName,
+                    int                  lineNumber,
+                    std::string_view     functionName,
+                    const boost::format &message) const noexcept override;
+
+  /**\brief append summary of the window, if it is over or finish is true.
+   * Next window starts with next record
+   */
+  void formatPending(RecordBuffer &buffer, bool finish) const noexcept override;
+
+  /**\return counters of current window, which aren't zero
+   */
+  std::vector<SiteMetrics> getMetrics() const noexcept;
+
+private:
+  detail::MetricsSlot &getSlot(CallSite *site) const noexcept;
+
+  /**\brief append summary of current window to the buffer and reset counters
+   */
+  void finishWindow(RecordBuffer &buffer) const noexcept;
+
+  std::chrono::system_clock::duration                 window_;
+  bool                                                keepLastMessage_;
+  /// id of slots in call sites, it is unique among existing frontends. Id of
+  /// destroyed frontend is reused with its slots by next one
+  std::uint64_t                                       id_;
+  /// end of current window, 0 before the first record
+  mutable std::atomic<std::chrono::system_clock::rep> windowEnd_;
+  /// slots of call sites, which have records accepted by the frontend
+  mutable std::atomic<detail::MetricsSlot *>          slots_;
+  /// slot for records without call site
+  std::unique_ptr<detail::MetricsSlot>                siteless_;
+};
+} // namespace logs
@@ -0,0 +1,206 @@
+// NamedLogger.hpp
+/**\file
+ * Hierarchical named loggers. Names separated by dots, like `db.pool` or
+ * `net.http`, and every logger inherits level of nearest parent, which has
+ * explicitly set level. Root logger has empty name and `Severity::Trace` level
+ * by default.
+ *
+ * Get logger once and use it with `LOG_*_TO` macroses:
+ *
+ * ```cpp
+ * static logs::NamedLogger &dbLogger = NAMED_LOGGER("db.pool");
+ * LOG_DEBUG_TO(dbLogger, "connections: %1%", count);
+ * ```
+ *
+ * Record, which passed level of named logger, is sent to sinks of
+ * `SimpleLogger` as usual, so filters of frontends are still used
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <simple_logs/LogsFront.hpp>
+
+namespace logs {
+class LoggerTree;
+
+class NamedLogger {
+  friend LoggerTree;
+
+public:
+  NamedLogger(LoggerTree &tree, std::string_view name)
+      : tree_{tree}
+      , name_{name}
+      , generation_{0}
+      , level_{Severity::Trace} {
+  }
+
+  std::string_view getName() const noexcept {
+    return name_;
+  }
+
+  /**\brief check that record with the severity must be logged
+   * \note effective level is cached, and recalculated only after changing
+   * some level in the tree
+   */
+  inline bool isEnabled(Severity severity) const noexcept;
+
+  Severity getEffectiveLevel() const noexcept {
+    isEnabled(Severity::Trace);
+    return level_.load(std::memory_order_relaxed);
+  }
+
+private:
+  void refresh() const noexcept;
+
+private:
+  LoggerTree                   &tree_;
+  std::string                   name_;
+  mutable std::atomic_uint64_t  generation_;
+  mutable std::atomic<Severity> level_;
+};
+
+class LoggerTree {
+  friend NamedLogger;
+
+public:
+  /**\return logger with the name. Returned reference is valid until end of
+   * program
+   * \note uses mutex, so better to store result of the function
+   */
+  NamedLogger &getLogger(std::string_view name) noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto found = loggers_.find(name);
+    if (found == loggers_.end()) {
+      found = loggers_
+                  .emplace(std::string{name},
+                           std::make_unique<NamedLogger>(*this, name))
+                  .first;
+    }
+    return *found->second;
+  }
+
+  /**\brief set level for the logger and all its children, which don't have
+   * own level
+   * \param name empty name means root logger
+   */
+  void setLevel(std::string_view name, Severity level) noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    levels_[std::string{name}] = level;
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  /**\brief remove level of the logger, so it will inherit level of parent
+   */
+  void resetLevel(std::string_view name) noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (auto found = levels_.find(name); found != levels_.end()) {
+      levels_.erase(found);
+      generation_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  /**\brief replace all levels at once
+   */
+  void
+  setLevels(std::map<std::string, Severity, std::less<>> levels) noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    levels_ = std::move(levels);
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  static LoggerTree &get() noexcept {
+    static LoggerTree tree;
+    return tree;
+  }
+
+private:
+  LoggerTree() noexcept
+      : generation_{1} {
+  }
+
+  LoggerTree(const LoggerTree &) = delete;
+  LoggerTree(LoggerTree &&)      = delete;
+
+  /**\note must be called under mutex
+   */
+  Severity findLevel(std::string_view name) const noexcept {
+    for (;;) {
+      if (auto found = levels_.find(name); found != levels_.end()) {
+        return found->second;
+      }
+      if (name.empty()) {
+        return Severity::Trace;
+      }
+
+      std::size_t pos = name.rfind('.');
+      name            = pos == std::string_view::npos ? std::string_view{}
+                                                      : name.substr(0, pos);
+    }
+  }
+
+private:
+  mutable std::mutex                                               mutex_;
+  std::map<std::string, Severity, std::less<>>                     levels_;
+  std::map<std::string, std::unique_ptr<NamedLogger>, std::less<>> loggers_;
+  std::atomic_uint64_t                                             generation_;
+};
+
+bool NamedLogger::isEnabled(Severity severity) const noexcept {
+  if (generation_.load(std::memory_order_acquire) !=
+      tree_.generation_.load(std::memory_order_acquire)) {
+    refresh();
+  }
+  return static_cast<int>(severity) >=
+         static_cast<int>(level_.load(std::memory_order_relaxed));
+}
+
+inline void NamedLogger::refresh() const noexcept {
+  std::lock_guard<std::mutex> lock{tree_.mutex_};
+  level_.store(tree_.findLevel(name_), std::memory_order_relaxed);
+  generation_.store(tree_.generation_.load(std::memory_order_relaxed),
+                    std::memory_order_release);
+}
+} // namespace logs
+
+#define NAMED_LOGGER(name) logs::LoggerTree::get().getLogger(name)
+
+#ifndef LOG_FORMAT_TO
+/**\brief log message by the named logger, it is one statement, so it can be
+ * used in `if` without braces
+ */
+#  define LOG_FORMAT_TO(logger, severity, ...)                                 \
+    do {                                                                       \
+      if ((logger).isEnabled(severity)) {                                      \
+        LOG_MESSAGE(severity, __VA_ARGS__)                                     \
+      }                                                                        \
+    } while (false)
+#endif
+
+#ifndef LOG_TRACE_TO
+#  define LOG_TRACE_TO(logger, ...)                                            \
+    LOG_FORMAT_TO(logger, logs::Severity::Trace, __VA_ARGS__)
+#endif
+
+#ifndef LOG_DEBUG_TO
+#  define LOG_DEBUG_TO(logger, ...)                                            \
+    LOG_FORMAT_TO(logger, logs::Severity::Debug, __VA_ARGS__)
+#endif
+
+#ifndef LOG_INFO_TO
+#  define LOG_INFO_TO(logger, ...)                                             \
+    LOG_FORMAT_TO(logger, logs::Severity::Info, __VA_ARGS__)
+#endif
+
+#ifndef LOG_WARNING_TO
+#  define LOG_WARNING_TO(logger, ...)                                          \
+    LOG_FORMAT_TO(logger, logs::Severity::Warning, __VA_ARGS__)
+#endif
+
+#ifndef LOG_ERROR_TO
+#  define LOG_ERROR_TO(logger, ...)                                            \
+    LOG_FORMAT_TO(logger, logs::Severity::Error, __VA_ARGS__)
+#endif
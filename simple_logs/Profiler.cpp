@@ -0,0 +1,117 @@
+// Profiler.cpp
+
+#include "Profiler.hpp"
+#include "logs.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <vector>
+
+namespace logs {
+CallSite::CallSite(std::string_view file,
+                   int              line,
+                   std::string_view function,
+                   Channels         recordChannel) noexcept
+    : fileName{file}
+    , lineNumber{line}
+    , functionName{function}
+    , channel{recordChannel}
+    , calls{0}
+    , records{0}
+    , bytes{0}
+    , nanoseconds{0}
+    , layoutCaches{nullptr}
+    , metricsSlots{nullptr}
+    , filterCaches{nullptr}
+    , next{nullptr} {
+  Profiler::get().add(*this);
+}
+
+void Profiler::reset() noexcept {
+  for (CallSite *site = sites_.load(std::memory_order_acquire);
+       site != nullptr;
+       site = site->next) {
+    site->calls.store(0, std::memory_order_relaxed);
+    site->records.store(0, std::memory_order_relaxed);
+    site->bytes.store(0, std::memory_order_relaxed);
+    site->nanoseconds.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Profiler::report(std::ostream &stream, std::size_t count) const noexcept {
+  struct Row {
+    const CallSite *site;
+    std::uint64_t   calls;
+    std::uint64_t   records;
+    std::uint64_t   bytes;
+    std::uint64_t   nanoseconds;
+  };
+
+  std::vector<Row> rows;
+  for (CallSite *site = sites_.load(std::memory_order_acquire);
+       site != nullptr;
+       site = site->next) {
+    Row row{site,
+            site->calls.load(std::memory_order_relaxed),
+            site->records.load(std::memory_order_relaxed),
+            site->bytes.load(std::memory_order_relaxed),
+            site->nanoseconds.load(std::memory_order_relaxed)};
+    if (row.calls != 0 || row.records != 0) {
+      rows.emplace_back(row);
+    }
+  }
+
+  count = std::min(count, rows.size());
+  std::partial_sort(rows.begin(),
+                    rows.begin() + count,
+                    rows.end(),
+                    [](const Row &lhs, const Row &rhs) {
+                      return lhs.nanoseconds > rhs.nanoseconds;
+                    });
+
+  std::ios::fmtflags flags = stream.flags();
+  stream << std::setw(11) << "calls" << std::setw(11) << "records"
+         << std::setw(11) << "bytes" << std::setw(11) << "total ms"
+         << std::setw(11) << "ns/call"
+         << "  call site" << std::endl;
+  for (std::size_t i = 0; i < count; ++i) {
+    const Row &row = rows[i];
+    stream << std::setw(11) << row.calls << std::setw(11) << row.records
+           << std::setw(11) << row.bytes << std::setw(11) << std::fixed
+           << std::setprecision(3) << row.nanoseconds / 1e6 << std::setw(11)
+           << (row.calls != 0 ? row.nanoseconds / row.calls : 0) << "  "
+           << row.site->fileName << ':' << row.site->lineNumber << ' '
+           << row.site->functionName << std::endl;
+  }
+  stream.flags(flags);
+}
+
+void Profiler::reportAtExit(std::size_t count) noexcept {
+  reportCount_ = count;
+
+  // the logger is created before registration of the handler, so it is
+  // destroyed after the handler is called
+  SimpleLogger::get();
+  [[maybe_unused]] static bool registered = std::atexit([]() {
+    // records, which are still in asynchronous queue, must be counted
+    SimpleLogger::get().flush();
+    Profiler &profiler = Profiler::get();
+    profiler.report(std::cerr, profiler.reportCount_);
+  }) == 0;
+}
+
+Profiler &Profiler::get() noexcept {
+  static Profiler profiler;
+  return profiler;
+}
+
+void Profiler::add(CallSite &site) noexcept {
+  CallSite *head = sites_.load(std::memory_order_relaxed);
+  do {
+    site.next = head;
+  } while (sites_.compare_exchange_weak(head,
+                                        &site,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed) == false);
+}
+} // namespace logs
@@ -0,0 +1,80 @@
+// Profiler.hpp
+/**\file
+ * Profiler of logging cost. It counts for every call site of logging macroses
+ * how many times the macro was called, how many records it produced, size of
+ * the records and total time of formatting and writing them. Time of writing
+ * in asynchronous mode is also counted.
+ *
+ * ```cpp
+ * logs::Profiler::get().start();
+ * logs::Profiler::get().reportAtExit();
+ * ```
+ *
+ * Report is a table of call sites with the biggest total time:
+ *
+ * ```
+ *      calls    records      bytes   total ms    ns/call  call site
+ *    1000000    1000000   48000000    812.331        812  db.cpp:42 query
+ * ```
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <simple_logs/LogsFront.hpp>
+
+namespace logs {
+class Profiler {
+  friend CallSite;
+
+public:
+  /**\brief start counting, counters, which were collected before, are kept
+   */
+  void start() noexcept {
+    running_.store(true, std::memory_order_relaxed);
+  }
+
+  void stop() noexcept {
+    running_.store(false, std::memory_order_relaxed);
+  }
+
+  bool isRunning() const noexcept {
+    return running_.load(std::memory_order_relaxed);
+  }
+
+  /**\brief set all counters to zero
+   */
+  void reset() noexcept;
+
+  /**\brief print table of call sites with the biggest total time
+   * \param count maximal count of call sites in the table
+   */
+  void report(std::ostream &stream, std::size_t count = 20) const noexcept;
+
+  /**\brief print report to `std::cerr` at exit of program
+   */
+  void reportAtExit(std::size_t count = 20) noexcept;
+
+  static Profiler &get() noexcept;
+
+private:
+  Profiler() noexcept
+      : running_{false}
+      , sites_{nullptr}
+      , reportCount_{0} {
+  }
+
+  Profiler(const Profiler &) = delete;
+  Profiler(Profiler &&)      = delete;
+
+  void add(CallSite &site) noexcept;
+
+private:
+  std::atomic_bool        running_;
+  /// list of all call sites, which were used
+  std::atomic<CallSite *> sites_;
+  std::size_t             reportCount_;
+};
+} // namespace logs
@@ -0,0 +1,181 @@
+// RequestBuffer.cpp
+
+#include "RequestBuffer.hpp"
+#include "AppendStreamBuffer.hpp"
+#include "logs.hpp"
+#include <exception>
+#include <ostream>
+
+namespace logs {
+namespace {
+/// innermost buffer of current thread
+thread_local RequestBuffer *currentBuffer = nullptr;
+
+/// size of argument, which is captured instead of printing
+constexpr std::uint32_t capturedSize = UINT32_MAX;
+
+/**\brief adapter for passing captured argument to boost::format
+ */
+struct CapturedRef {
+  const detail::CapturedArgument &argument;
+};
+
+std::ostream &operator<<(std::ostream &stream, CapturedRef ref) {
+  ref.argument.print(stream);
+  return stream;
+}
+
+/**\return true if the format contains only placeholders `%N%` and `%%`, so
+ * printed arguments can be substituted to it as strings
+ */
+bool isPositional(std::string_view format) noexcept {
+  for (std::size_t i = format.find('%'); i != std::string_view::npos;
+       i             = format.find('%', i + 1)) {
+    std::size_t end = format.find('%', i + 1);
+    if (end == std::string_view::npos) {
+      return false;
+    }
+    for (std::size_t j = i + 1; j < end; ++j) {
+      if (format[j] < '0' || format[j] > '9') {
+        return false;
+      }
+    }
+    i = end;
+  }
+  return true;
+}
+} // namespace
+
+RequestBuffer::RequestBuffer(RequestBufferSettings settings) noexcept
+    : settings_{settings}
+    , start_{Clock::now()}
+    , exceptions_{std::uncaught_exceptions()}
+    , failed_{false}
+    , dropped_{0}
+    , previous_{currentBuffer} {
+  currentBuffer = this;
+}
+
+RequestBuffer::~RequestBuffer() {
+  currentBuffer = previous_;
+  if (failed_ || std::uncaught_exceptions() > exceptions_ ||
+      Clock::now() - start_ >= settings_.latencyThreshold) {
+    emit();
+  }
+}
+
+void RequestBuffer::emit() noexcept {
+  std::size_t          offset   = 0;
+  const std::uint32_t *size     = sizes_.data();
+  auto                 captured = captured_.begin();
+  for (const Record &record : records_) {
+    boost::format message =
+        getLogFormat(std::string_view{data_.data() + offset, *size});
+    offset += *size++;
+    for (std::uint32_t i = 0; i < record.count; ++i, ++size) {
+      if (*size == capturedSize) {
+        message % CapturedRef{**captured++};
+        continue;
+      }
+      message % std::string_view{data_.data() + offset, *size};
+      offset += *size;
+    }
+
+    LOGGER.log(*record.site,
+               record.severity,
+               std::move(message),
+               RecordOrigin{record.time, record.threadId});
+  }
+  discard();
+}
+
+void RequestBuffer::discard() noexcept {
+  records_.clear();
+  data_.clear();
+  sizes_.clear();
+  captured_.clear();
+}
+
+RequestBuffer *RequestBuffer::current() noexcept {
+  return currentBuffer;
+}
+
+void RequestBuffer::setCurrent(RequestBuffer *buffer) noexcept {
+  currentBuffer = buffer;
+}
+
+bool RequestBuffer::keepRecord(CallSite               &site,
+                               Severity                severity,
+                               std::string_view        messageFormat,
+                               const detail::Argument *arguments,
+                               std::size_t             count) noexcept {
+  RequestBuffer *buffer = currentBuffer;
+  if (buffer == nullptr) {
+    return false;
+  }
+  buffer->keep(site, severity, messageFormat, arguments, count);
+  return true;
+}
+
+void RequestBuffer::keep(CallSite               &site,
+                         Severity                severity,
+                         std::string_view        messageFormat,
+                         const detail::Argument *arguments,
+                         std::size_t             count) noexcept {
+  // LOG_FAILURE finishes program without unwinding of stack, so the buffer is
+  // written right after the record
+  bool fatal =
+      static_cast<int>(severity) == static_cast<int>(Severity::Failure);
+  if (fatal || static_cast<int>(severity) >=
+                   static_cast<int>(settings_.failureSeverity)) {
+    failed_ = true;
+  }
+  // synchronous records are written before returning, as without the buffer,
+  // and records, which were kept before them, are written first
+  bool urgent = fatal || LOGGER.isSynchronous(severity);
+  if (records_.size() >= settings_.maxRecords && urgent == false) {
+    ++dropped_;
+    return;
+  }
+
+  if (isPositional(messageFormat)) {
+    thread_local detail::AppendStreamBuffer<std::string> output;
+    thread_local std::ostream stream{&output};
+    output.setOutput(&data_);
+
+    data_ += messageFormat;
+    sizes_.push_back(messageFormat.size());
+    for (std::size_t i = 0; i < count; ++i) {
+      if (arguments[i].capture != nullptr) {
+        // the argument is printed only if the buffer is written
+        captured_.emplace_back(arguments[i].capture(arguments[i].value));
+        sizes_.push_back(capturedSize);
+        continue;
+      }
+
+      std::size_t begin = data_.size();
+      arguments[i].print(stream, arguments[i].value);
+      sizes_.push_back(data_.size() - begin);
+    }
+  } else {
+    // specifications of placeholders can not be applied to printed arguments,
+    // so message is formatted now
+    std::string message =
+        detail::formatArguments(messageFormat, arguments, count);
+    data_ += "%1%";
+    data_ += message;
+    sizes_.push_back(3);
+    sizes_.push_back(message.size());
+    count = 1;
+  }
+
+  records_.push_back(Record{&site,
+                            severity,
+                            std::chrono::system_clock::now(),
+                            std::this_thread::get_id(),
+                            static_cast<std::uint32_t>(count)});
+  if (urgent) {
+    emit();
+  }
+}
+} // namespace logs
@@ -0,0 +1,160 @@
+// RequestBuffer.hpp
+/**\file
+ * Tail-based buffering of records of request. Records, which are logged by
+ * current thread while buffer exists, are kept in the buffer instead of sinks.
+ * At end of the request they are written, if the request failed or took too
+ * much time, and dropped otherwise:
+ *
+ * ```cpp
+ * void handle(const Request &request) {
+ *   logs::RequestBuffer buffer;
+ *   LOG_DEBUG("request: %1%", request.body);
+ *   if (process(request) == false) {
+ *     buffer.setFailed();
+ *   }
+ * }
+ * ```
+ *
+ * Request is failed, if `setFailed` was called, if record with severity
+ * `Error` or higher was logged, or if the buffer is destroyed by exception.
+ * Record with severity `Failure` writes the buffer immediately, because
+ * program is finished after it. So does record, which must be written
+ * synchronously in asynchronous mode (\see AsyncSettings::synchronous).
+ *
+ * Arguments are printed to the buffer at logging, because they can be changed
+ * later, but message isn't formatted, so good request costs only appending
+ * to the buffer. Arguments, which `formatter` can capture, are captured
+ * instead and printed only if the buffer is written. Written records have
+ * time and thread of logging. Kept records bypass sampling of requests (\see
+ * RequestScope) and deadlines (\see DeadlineScope), because records of slow
+ * and failed requests are needed
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <simple_logs/LogsFront.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace logs {
+/**\brief settings of RequestBuffer
+ */
+struct RequestBufferSettings {
+  /// records are written, if the request takes more time
+  std::chrono::steady_clock::duration latencyThreshold =
+      std::chrono::seconds{1};
+
+  /// request is failed, if record with the severity or higher is logged
+  Severity failureSeverity = Severity::Error;
+
+  /// records, which are logged after the count, are dropped and counted
+  std::size_t maxRecords = 1024;
+};
+
+/**\brief keeps records of current thread until end of scope
+ *
+ * Buffers can be nested, records are kept by the innermost buffer. Written
+ * records of inner buffer aren't passed to outer buffer
+ * \note buffer of coroutine, which is resumed by other threads, must be
+ * carried by ContextCarrier::withScopes
+ */
+class RequestBuffer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit RequestBuffer(
+      RequestBufferSettings settings = RequestBufferSettings{}) noexcept;
+
+  /**\brief write kept records, if the request failed or took too much time
+   */
+  ~RequestBuffer();
+
+  RequestBuffer(const RequestBuffer &) = delete;
+  RequestBuffer(RequestBuffer &&)      = delete;
+
+  void setFailed() noexcept {
+    failed_ = true;
+  }
+
+  bool isFailed() const noexcept {
+    return failed_;
+  }
+
+  /**\return count of kept records
+   */
+  std::size_t getSize() const noexcept {
+    return records_.size();
+  }
+
+  /**\return count of records, which were dropped because the buffer was full
+   */
+  std::uint64_t getDropped() const noexcept {
+    return dropped_;
+  }
+
+  /**\brief write kept records now, next records are kept again
+   */
+  void emit() noexcept;
+
+  /**\brief drop kept records
+   */
+  void discard() noexcept;
+
+  /**\brief called by logging macroses before formatting of message
+   * \return true if record is kept by buffer of current thread
+   */
+  static bool keepRecord(CallSite               &site,
+                         Severity                severity,
+                         std::string_view        messageFormat,
+                         const detail::Argument *arguments,
+                         std::size_t             count) noexcept;
+
+  /**\return innermost buffer of current thread, or nullptr
+   */
+  static RequestBuffer *current() noexcept;
+
+private:
+  friend class ContextCarrier;
+
+  /**\brief set innermost buffer of current thread \see ContextCarrier
+   */
+  static void setCurrent(RequestBuffer *buffer) noexcept;
+
+  using CapturedArguments =
+      std::vector<std::unique_ptr<detail::CapturedArgument>>;
+
+  struct Record {
+    CallSite                             *site;
+    Severity                              severity;
+    std::chrono::system_clock::time_point time;
+    std::thread::id                       threadId;
+    /// count of arguments, format and arguments are stored in `data_` one by
+    /// one, their sizes are stored in `sizes_`
+    std::uint32_t                         count;
+  };
+
+  void keep(CallSite               &site,
+            Severity                severity,
+            std::string_view        messageFormat,
+            const detail::Argument *arguments,
+            std::size_t             count) noexcept;
+
+  RequestBufferSettings      settings_;
+  Clock::time_point          start_;
+  /// count of uncaught exceptions at creation of the buffer
+  int                        exceptions_;
+  bool                       failed_;
+  std::uint64_t              dropped_;
+  std::vector<Record>        records_;
+  std::string                data_;
+  std::vector<std::uint32_t> sizes_;
+  /// arguments, which are captured instead of printing, their sizes are
+  /// `UINT32_MAX`
+  CapturedArguments          captured_;
+  RequestBuffer             *previous_;
+};
+} // namespace logs
@@ -0,0 +1,89 @@
+// RequestContext.cpp
+
+#include "RequestContext.hpp"
+#include "Deadline.hpp"
+#include "RequestBuffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace logs {
+namespace {
+/// sampling rate is set with the precision
+constexpr std::uint32_t samplingScale = 1000000;
+
+/// request is sampled if hash of its trace id modulo scale is less than the
+/// threshold. High bits of FNV-1a depend weakly on last characters of short
+/// ids, so they aren't compared directly
+std::atomic_uint32_t  samplingThreshold{samplingScale};
+std::atomic<Severity> sampledSeverity{Severity::Debug};
+
+thread_local const RequestContext *currentContext = nullptr;
+} // namespace
+
+void setSampling(SamplingSettings settings) noexcept {
+  double rate = std::clamp(settings.rate, 0.0, 1.0);
+  samplingThreshold.store(static_cast<std::uint32_t>(rate * samplingScale),
+                          std::memory_order_relaxed);
+  sampledSeverity.store(settings.severity, std::memory_order_relaxed);
+}
+
+bool isRequestSampled(std::string_view traceId) noexcept {
+  return hashName(traceId) % samplingScale <
+         samplingThreshold.load(std::memory_order_relaxed);
+}
+
+RequestContext::RequestContext(std::string traceId) noexcept
+    : traceId_{std::move(traceId)}
+    , droppedSeverity_{Severity::Placeholder} {
+  if (isRequestSampled(traceId_) == false) {
+    droppedSeverity_ = sampledSeverity.load(std::memory_order_relaxed);
+  }
+}
+
+ContextCarrier::ContextCarrier() noexcept
+    : context_{currentContext}
+    , buffer_{nullptr}
+    , deadline_{nullptr} {
+}
+
+ContextCarrier ContextCarrier::withScopes() noexcept {
+  return ContextCarrier{currentContext,
+                        RequestBuffer::current(),
+                        DeadlineScope::current()};
+}
+
+ContextCarrier ContextCarrier::install() const noexcept {
+  ContextCarrier previous = withScopes();
+  restore(*this);
+  return previous;
+}
+
+void ContextCarrier::restore(const ContextCarrier &previous) noexcept {
+  currentContext = previous.context_;
+  RequestBuffer::setCurrent(previous.buffer_);
+  DeadlineScope::setCurrent(previous.deadline_);
+}
+
+RequestScope::RequestScope(const RequestContext &context) noexcept
+    : previous_{ContextCarrier::withScopes()} {
+  currentContext = &context;
+}
+
+RequestScope::RequestScope(const ContextCarrier &carrier) noexcept
+    : previous_{carrier.install()} {
+}
+
+RequestScope::~RequestScope() {
+  ContextCarrier::restore(previous_);
+}
+
+const RequestContext *RequestScope::current() noexcept {
+  return currentContext;
+}
+
+bool RequestScope::dropRecord(Severity severity) noexcept {
+  const RequestContext *context = currentContext;
+  return context != nullptr && context->isDropped(severity);
+}
+} // namespace logs
@@ -0,0 +1,211 @@
+// RequestContext.hpp
+/**\file
+ * Context of request, which is processed by current thread, and sampling of
+ * records by requests. Debug records of request are kept or dropped together,
+ * so sampled requests have complete narratives:
+ *
+ * ```cpp
+ * logs::setSampling(logs::SamplingSettings{0.01, logs::Severity::Debug});
+ *
+ * void handle(const Request &request) {
+ *   logs::RequestContext context{request.traceId};
+ *   logs::RequestScope   scope{context};
+ *   LOG_DEBUG("request: %1%", request.body);
+ * }
+ * ```
+ *
+ * Decision depends only on trace id: request is sampled if 32-bit FNV-1a hash
+ * of trace id (\see hashName) modulo 1000000 is less than `rate * 1000000`.
+ * So other services, which use same hash and rate, keep records of same
+ * requests. Records of not
+ * sampled requests are dropped before formatting of message.
+ *
+ * Request, which is processed by coroutines or asynchronous handlers, moves
+ * between threads, so its context is moved by ContextCarrier. Handlers are
+ * wrapped by carrier, they can run concurrently. Coroutine is resumed by one
+ * thread at a time, so it can carry RequestBuffer and DeadlineScope of the
+ * request too. It keeps carrier in its frame, which takes state of thread at
+ * every suspension and installs it after resumption:
+ *
+ * ```cpp
+ * logs::ContextCarrier carrier{context};
+ * asio::post(executor, carrier.wrap([]() {
+ *   LOG_DEBUG("on other thread");
+ * }));
+ *
+ * // in await_resume of awaiter of coroutine
+ * promise.previous = promise.carrier.install();
+ * // in await_suspend and final_suspend
+ * promise.carrier = logs::ContextCarrier::withScopes();
+ * logs::ContextCarrier::restore(promise.previous);
+ * ```
+ */
+
+#pragma once
+
+#include <simple_logs/LogsFront.hpp>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace logs {
+class DeadlineScope;
+class RequestBuffer;
+
+/**\brief settings of sampling of records by requests
+ * \see setSampling
+ */
+struct SamplingSettings {
+  /// part of requests, which records are kept, from 0 to 1
+  double rate = 1;
+
+  /// records of not sampled requests with the severity or lower are dropped,
+  /// other records are always kept
+  Severity severity = Severity::Debug;
+};
+
+/**\brief set sampling for requests, which will be created after the call
+ */
+void setSampling(SamplingSettings settings) noexcept;
+
+/**\return true if records of request with the trace id are kept by current
+ * settings of sampling. Use it for passing trace id explicitly
+ */
+bool isRequestSampled(std::string_view traceId) noexcept;
+
+/**\brief context of request, sampling decision is made at its creation
+ */
+class RequestContext {
+public:
+  explicit RequestContext(std::string traceId) noexcept;
+
+  const std::string &getTraceId() const noexcept {
+    return traceId_;
+  }
+
+  bool isSampled() const noexcept {
+    // operator== of severities makes predicate, \see SeverityPredicat
+    return static_cast<int>(droppedSeverity_) ==
+           static_cast<int>(Severity::Placeholder);
+  }
+
+  /**\return true if records of the request with the severity are dropped
+   */
+  bool isDropped(Severity severity) const noexcept {
+    return static_cast<int>(severity) <= static_cast<int>(droppedSeverity_);
+  }
+
+private:
+  std::string traceId_;
+  /// Placeholder if the request is sampled
+  Severity    droppedSeverity_;
+};
+
+/**\brief pointer to context of request, which can be moved between threads
+ * with the request. Installing is a swap of pointers
+ *
+ * Context is immutable, so it can be used by several threads at once.
+ * RequestBuffer and DeadlineScope of the request are carried only on demand,
+ * \see withScopes. Installed carrier without them hides buffer and scope of
+ * the thread, so records of other requests aren't kept in them
+ * \note carried objects must be valid while they are carried
+ */
+class ContextCarrier {
+public:
+  /**\brief carry context of current thread, it can be nullptr
+   */
+  ContextCarrier() noexcept;
+
+  /**\brief carry only the context
+   */
+  explicit ContextCarrier(const RequestContext &context) noexcept
+      : context_{&context}
+      , buffer_{nullptr}
+      , deadline_{nullptr} {
+  }
+
+  /**\brief carry context, request buffer and deadline scope of current
+   * thread, they can be nullptr
+   * \warning buffer and scope aren't thread safe, so the carrier, and its
+   * copies, must be installed by one thread at a time, as coroutine is. Carried
+   * buffer and scope must be valid until last installed carrier is restored
+   */
+  static ContextCarrier withScopes() noexcept;
+
+  /**\return carried context, or nullptr
+   */
+  const RequestContext *getContext() const noexcept {
+    return context_;
+  }
+
+  /**\brief set the carried context, buffer and deadline for current thread
+   * \return previous state of current thread with its buffer and deadline, it
+   * must be restored, when current thread stops to process the request
+   */
+  ContextCarrier install() const noexcept;
+
+  /**\brief set state, which was returned by install, for current thread
+   */
+  static void restore(const ContextCarrier &previous) noexcept;
+
+  /**\return handler, which calls the handler with the carried context. By
+   * default copies of the handler can be called concurrently
+   */
+  template <typename Handler>
+  auto wrap(Handler handler) const;
+
+private:
+  ContextCarrier(const RequestContext *context,
+                 RequestBuffer        *buffer,
+                 DeadlineScope        *deadline) noexcept
+      : context_{context}
+      , buffer_{buffer}
+      , deadline_{deadline} {
+  }
+
+private:
+  const RequestContext *context_;
+  RequestBuffer        *buffer_;
+  DeadlineScope        *deadline_;
+};
+
+/**\brief set the context for current thread until end of scope
+ * \note the context must be valid until end of the scope
+ * \warning scope must not be kept over suspension of coroutine, because it
+ * can be resumed by other thread, \see ContextCarrier
+ */
+class RequestScope {
+public:
+  explicit RequestScope(const RequestContext &context) noexcept;
+
+  /**\brief set carried context, if carrier is empty, then current thread
+   * has no context until end of scope
+   */
+  explicit RequestScope(const ContextCarrier &carrier) noexcept;
+  ~RequestScope();
+
+  RequestScope(const RequestScope &) = delete;
+  RequestScope(RequestScope &&)      = delete;
+
+  /**\return context of current thread, or nullptr
+   */
+  static const RequestContext *current() noexcept;
+
+  /**\brief called by logging macroses before formatting of message
+   * \return true if record is dropped by sampling of current request
+   */
+  static bool dropRecord(Severity severity) noexcept;
+
+private:
+  ContextCarrier previous_;
+};
+
+template <typename Handler>
+auto ContextCarrier::wrap(Handler handler) const {
+  return [carrier = *this,
+          handler = std::move(handler)](auto &&...args) mutable {
+    RequestScope scope{carrier};
+    return handler(std::forward<decltype(args)>(args)...);
+  };
+}
+} // namespace logs
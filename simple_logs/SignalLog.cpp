@@ -0,0 +1,252 @@
+// SignalLog.cpp
+
+#include "SignalLog.hpp"
+#include "logs.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <unistd.h>
+
+namespace logs {
+namespace {
+/// record of file descriptor contains also severity, file name and line
+constexpr std::size_t signalLineSize = signalRecordSize + 128;
+
+/**\brief buffer on stack, characters, which don't fit it, are dropped
+ */
+template <std::size_t N>
+class FixedBuffer {
+public:
+  void append(char c) noexcept {
+    if (size_ < N) {
+      data_[size_++] = c;
+    }
+  }
+
+  void append(std::string_view str) noexcept {
+    std::size_t count = std::min(str.size(), N - size_);
+    std::copy_n(str.data(), count, data_ + size_);
+    size_ += count;
+  }
+
+  void appendNumber(SignalArgument number) noexcept {
+    char        digits[20];
+    std::size_t count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + number.absolute % 10);
+      number.absolute /= 10;
+    } while (number.absolute != 0);
+
+    if (number.negative) {
+      append('-');
+    }
+    while (count != 0) {
+      append(digits[--count]);
+    }
+  }
+
+  /**\brief append new line, last character is replaced if the buffer is full
+   */
+  void appendNewLine() noexcept {
+    if (size_ == N) {
+      --size_;
+    }
+    append('\n');
+  }
+
+  std::string_view view() const noexcept {
+    return std::string_view{data_, size_};
+  }
+
+private:
+  char        data_[N];
+  std::size_t size_ = 0;
+};
+
+/**\brief same as toString, but without allocation
+ */
+std::string_view severityName(Severity severity) noexcept {
+  switch (severity) {
+  case Severity::Trace:
+    return TRACE_SEVERITY;
+  case Severity::Debug:
+    return DEBUG_SEVERITY;
+  case Severity::Info:
+    return INFO_SEVERITY;
+  case Severity::Warning:
+    return WARNING_SEVERITY;
+  case Severity::Error:
+    return ERROR_SEVERITY;
+  case Severity::Failure:
+    return FAILURE_SEVERITY;
+  case Severity::Throw:
+    return THROW_SEVERITY;
+  default:
+    return "";
+  }
+}
+
+/**\brief format message like boost::format, but only with integers. Invalid
+ * placeholders are printed as is, placeholders without arguments are empty
+ */
+void formatMessage(FixedBuffer<signalRecordSize> &output,
+                   std::string_view               messageFormat,
+                   const SignalArgument          *arguments,
+                   std::size_t                    count) noexcept {
+  for (std::size_t i = 0; i < messageFormat.size(); ++i) {
+    if (messageFormat[i] != '%') {
+      output.append(messageFormat[i]);
+      continue;
+    }
+
+    std::size_t end = messageFormat.find('%', i + 1);
+    if (end == i + 1) {
+      output.append('%');
+      i = end;
+      continue;
+    }
+
+    std::size_t index = 0;
+    bool        valid = end != std::string_view::npos;
+    for (std::size_t j = i + 1; valid && j < end; ++j) {
+      valid = messageFormat[j] >= '0' && messageFormat[j] <= '9';
+      index = std::min(index * 10 + (messageFormat[j] - '0'), count + 1);
+    }
+    if (valid == false || index == 0) {
+      output.append('%');
+      continue;
+    }
+
+    if (index <= count) {
+      output.appendNumber(arguments[index - 1]);
+    }
+    i = end;
+  }
+}
+
+// initialized at compile time, so it is valid before initialization of other
+// static objects
+SignalLog signalLog;
+} // namespace
+
+void SignalLog::setFileDescriptors(const int  *fileDescriptors,
+                                   std::size_t count) noexcept {
+  count = std::min(count, maxSignalFileDescriptors);
+  for (std::size_t i = 0; i < count; ++i) {
+    fileDescriptors_[i].store(fileDescriptors[i], std::memory_order_relaxed);
+  }
+  fileDescriptorCount_.store(count, std::memory_order_release);
+}
+
+void SignalLog::log(Severity              severity,
+                    std::string_view      fileName,
+                    int                   lineNumber,
+                    std::string_view      functionName,
+                    std::string_view      messageFormat,
+                    const SignalArgument *arguments,
+                    std::size_t           count) noexcept {
+  // signal handler must not change errno of interrupted code
+  int savedErrno = errno;
+
+  FixedBuffer<signalRecordSize> message;
+  formatMessage(message, messageFormat, arguments, count);
+
+  if (fileDescriptorCount_.load(std::memory_order_acquire) == 0) {
+    push(severity, fileName, lineNumber, functionName, message.view());
+  } else {
+    // same as LIGHT_LOG_FORMAT
+    FixedBuffer<signalLineSize> line;
+    line.append(severityName(severity));
+    line.append(' ');
+    line.append(fileName);
+    line.append(':');
+    line.appendNumber(detail::makeSignalArgument(lineNumber));
+    line.append(" | ");
+    line.append(message.view());
+    line.appendNewLine();
+    write(line.view());
+  }
+
+  errno = savedErrno;
+}
+
+std::size_t SignalLog::drain() noexcept {
+  std::lock_guard<std::mutex> lock{drainMutex_};
+  std::size_t                 count = 0;
+  for (;; ++head_, ++count) {
+    Slot         &slot = slots_[head_ % signalRingSize];
+    std::uint64_t lap  = head_ - head_ % signalRingSize;
+    if (slot.sequence.load(std::memory_order_acquire) != lap + 1) {
+      return count;
+    }
+
+    Severity         severity     = slot.severity;
+    std::string_view fileName     = slot.fileName;
+    int              lineNumber   = slot.lineNumber;
+    std::string_view functionName = slot.functionName;
+    std::string      message{slot.message, slot.size};
+    slot.sequence.store(lap + signalRingSize, std::memory_order_release);
+
+    boost::format format = getLogFormat("%1%");
+    format % message;
+    LOGGER.log(severity,
+               fileName,
+               lineNumber,
+               functionName,
+               std::move(format));
+  }
+}
+
+SignalLog &SignalLog::get() noexcept {
+  return signalLog;
+}
+
+void SignalLog::write(std::string_view line) noexcept {
+  std::size_t count = fileDescriptorCount_.load(std::memory_order_acquire);
+  for (std::size_t i = 0; i < count; ++i) {
+    int         file    = fileDescriptors_[i].load(std::memory_order_relaxed);
+    std::size_t written = 0;
+    while (written < line.size()) {
+      ssize_t result =
+          ::write(file, line.data() + written, line.size() - written);
+      if (result < 0 && errno == EINTR) {
+        continue;
+      } else if (result <= 0) {
+        break;
+      }
+      written += result;
+    }
+  }
+}
+
+void SignalLog::push(Severity         severity,
+                     std::string_view fileName,
+                     int              lineNumber,
+                     std::string_view functionName,
+                     std::string_view message) noexcept {
+  std::uint64_t position = tail_.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot         &slot     = slots_[position % signalRingSize];
+    std::uint64_t lap      = position - position % signalRingSize;
+    std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence < lap) {
+      // the slot is not read yet since previous lap
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else if (sequence > lap) {
+      // the slot is taken by other writer
+      position = tail_.load(std::memory_order_relaxed);
+    } else if (tail_.compare_exchange_weak(
+                   position, position + 1, std::memory_order_relaxed)) {
+      slot.severity     = severity;
+      slot.fileName     = fileName;
+      slot.lineNumber   = lineNumber;
+      slot.functionName = functionName;
+      slot.size         = message.size();
+      std::copy(message.begin(), message.end(), slot.message);
+      slot.sequence.store(lap + 1, std::memory_order_release);
+      return;
+    }
+  }
+}
+} // namespace logs
@@ -0,0 +1,190 @@
+// SignalLog.hpp
+/**\file
+ * Logging from signal handlers. Usual logging macroses can not be used in
+ * signal handlers, because they allocate memory, lock mutexes and use
+ * iostreams. `LOG_SIGNAL_SAFE` is restricted version of `LOG_MESSAGE`, which
+ * only calls async-signal-safe functions:
+ *
+ * ```cpp
+ * void onSignal(int signal) {
+ *   LOG_SIGNAL_SAFE(logs::Severity::Warning, "got signal %1%", signal);
+ * }
+ * ```
+ *
+ * Format of message must be string literal, arguments can be only integers.
+ * Record is formatted to buffer on stack, it is truncated to
+ * `signalRecordSize` characters. Then it is written by `write(2)` to file
+ * descriptors, which were set by `SignalLog::setFileDescriptors`, or, if there
+ * are no file descriptors, pushed to lock-free ring with preallocated records.
+ * Records of the ring are written to LOGGER by `SignalLog::drain`, which must
+ * be called outside of signal handlers, for example by main loop after
+ * handling of signal. Records are dropped, if the ring is full
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <simple_logs/LogsFront.hpp>
+#include <string_view>
+#include <type_traits>
+
+namespace logs {
+/// maximal size of signal safe record, longer records are truncated
+constexpr std::size_t signalRecordSize = 256;
+
+/// count of records in ring of SignalLog
+constexpr std::size_t signalRingSize = 64;
+
+/// maximal count of file descriptors of SignalLog
+constexpr std::size_t maxSignalFileDescriptors = 4;
+
+/**\brief integer argument of signal safe record
+ */
+struct SignalArgument {
+  std::uint64_t absolute;
+  bool          negative;
+};
+
+/**\brief writes records, which are logged by `LOG_SIGNAL_SAFE`
+ * \note the object is initialized at compile time, so it can be used in
+ * signal handlers at any time
+ */
+class SignalLog {
+public:
+  constexpr SignalLog() noexcept
+      : fileDescriptors_{}
+      , fileDescriptorCount_{0}
+      , drainMutex_{}
+      , head_{0}
+      , tail_{0}
+      , dropped_{0}
+      , slots_{} {
+  }
+
+  SignalLog(const SignalLog &) = delete;
+  SignalLog(SignalLog &&)      = delete;
+
+  /**\brief records will be written directly to the file descriptors, for
+   * example `STDERR_FILENO`. Extra file descriptors are ignored. If there are
+   * no file descriptors, then records are pushed to the ring
+   * \note call it before installing signal handlers, file descriptors must be
+   * open until end of program
+   */
+  void setFileDescriptors(const int  *fileDescriptors,
+                          std::size_t count) noexcept;
+
+  /**\brief format record and write it, called by `LOG_SIGNAL_SAFE`
+   * \note async-signal-safe
+   * \param arguments array of `count` arguments
+   */
+  void log(Severity              severity,
+           std::string_view      fileName,
+           int                   lineNumber,
+           std::string_view      functionName,
+           std::string_view      messageFormat,
+           const SignalArgument *arguments,
+           std::size_t           count) noexcept;
+
+  /**\brief write records of the ring to LOGGER
+   * \warning it is not async-signal-safe, don't call it from signal handlers
+   * \return count of written records
+   */
+  std::size_t drain() noexcept;
+
+  /**\return count of records, which were dropped, because the ring was full
+   */
+  std::uint64_t getDropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  static SignalLog &get() noexcept;
+
+private:
+  /**\brief preallocated record of the ring
+   */
+  struct Slot {
+    /// lap of position for empty slot, next value for filled slot
+    std::atomic_uint64_t sequence{0};
+    Severity             severity{Severity::Placeholder};
+    std::string_view     fileName;
+    int                  lineNumber{0};
+    std::string_view     functionName;
+    std::size_t          size{0};
+    char                 message[signalRecordSize]{};
+  };
+
+  static_assert(std::atomic_uint64_t::is_always_lock_free &&
+                    std::atomic_int::is_always_lock_free,
+                "signal safe logging requires lock-free atomics");
+
+  /**\brief write the line to all file descriptors
+   */
+  void write(std::string_view line) noexcept;
+
+  void push(Severity         severity,
+            std::string_view fileName,
+            int              lineNumber,
+            std::string_view functionName,
+            std::string_view message) noexcept;
+
+private:
+  /// only first `fileDescriptorCount_` items are used
+  std::atomic_int      fileDescriptors_[maxSignalFileDescriptors];
+  std::atomic_size_t   fileDescriptorCount_;
+  std::mutex           drainMutex_;
+  /// position of next record for reading, guarded by `drainMutex_`
+  std::uint64_t        head_;
+  /// position of next record for writing
+  std::atomic_uint64_t tail_;
+  std::atomic_uint64_t dropped_;
+  Slot                 slots_[signalRingSize];
+};
+
+namespace detail {
+template <typename T>
+constexpr SignalArgument makeSignalArgument(T value) noexcept {
+  static_assert(std::is_integral_v<T>,
+                "only integers can be logged from signal handlers");
+  if constexpr (std::is_signed_v<T>) {
+    if (value < 0) {
+      // negation in unsigned type, so minimal value doesn't overflow
+      return SignalArgument{0 - static_cast<std::uint64_t>(value), true};
+    }
+  }
+  return SignalArgument{static_cast<std::uint64_t>(value), false};
+}
+
+/**\brief entry point of `LOG_SIGNAL_SAFE`
+ */
+template <typename... Args>
+void logSignalSafe(Severity         severity,
+                   std::string_view fileName,
+                   int              lineNumber,
+                   std::string_view functionName,
+                   std::string_view messageFormat,
+                   Args... args) noexcept {
+  // one more item, because array can not be empty
+  const SignalArgument arguments[sizeof...(Args) + 1] = {
+      makeSignalArgument(args)..., SignalArgument{0, false}};
+  SignalLog::get().log(severity,
+                       fileName,
+                       lineNumber,
+                       functionName,
+                       messageFormat,
+                       arguments,
+                       sizeof...(Args));
+}
+} // namespace detail
+} // namespace logs
+
+#ifndef LOG_SIGNAL_SAFE
+/**\brief log message from signal handler, first argument is format of
+ * message, other arguments must be integers
+ * \see SignalLog
+ */
+#  define LOG_SIGNAL_SAFE(severity, ...)                                       \
+    logs::detail::logSignalSafe(                                               \
+        severity, LOGS_FILE_NAME, __LINE__, LOGS_FUNCTION_NAME, __VA_ARGS__);
+#endif
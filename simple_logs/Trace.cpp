@@ -0,0 +1,243 @@
+// Trace.cpp
+
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+
+namespace logs {
+namespace {
+constexpr std::string_view traceMagic = "LOGSTRC1";
+
+/// entries of buffer are written to file after the size
+constexpr std::size_t traceBufferSize = 64 * 1024;
+
+/// sizes of other arguments of record are not stored
+constexpr std::size_t maxTraceArguments = 16;
+
+/**\brief counts printed characters without storing them
+ */
+class CountingStreamBuffer final : public std::streambuf {
+public:
+  std::size_t takeSize() noexcept {
+    std::size_t size = size_;
+    size_            = 0;
+    return size;
+  }
+
+protected:
+  int_type overflow(int_type c) override {
+    ++size_;
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *, std::streamsize count) override {
+    size_ += count;
+    return count;
+  }
+
+private:
+  std::size_t size_ = 0;
+};
+
+void appendNumber(std::string &buffer, std::uint64_t value) {
+  do {
+    unsigned char byte = value & 0x7f;
+    value >>= 7;
+    if (value != 0) {
+      byte |= 0x80;
+    }
+    buffer += static_cast<char>(byte);
+  } while (value != 0);
+}
+
+void appendString(std::string &buffer, std::string_view str) {
+  appendNumber(buffer, str.size());
+  buffer += str;
+}
+
+std::uint64_t readNumber(std::istream &stream) noexcept(false) {
+  std::uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = stream.get();
+    if (byte == std::istream::traits_type::eof()) {
+      throw std::runtime_error{"unexpected end of trace"};
+    }
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw std::runtime_error{"invalid number in trace"};
+}
+
+std::string readString(std::istream &stream) noexcept(false) {
+  std::string str(readNumber(stream), '\0');
+  if (stream.read(str.data(), str.size()).fail()) {
+    throw std::runtime_error{"unexpected end of trace"};
+  }
+  return str;
+}
+} // namespace
+
+void TraceRecorder::start(const std::string &fileName) noexcept(false) {
+  stop();
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  file_.open(fileName, std::ios::binary | std::ios::trunc);
+  if (file_.is_open() == false) {
+    throw std::runtime_error{"can not open trace file: " + fileName};
+  }
+  file_ << traceMagic;
+
+  buffer_.clear();
+  sites_.clear();
+  threads_.clear();
+  last_ = std::chrono::steady_clock::now();
+  recording_.store(true, std::memory_order_relaxed);
+
+  [[maybe_unused]] static bool registered = std::atexit([]() {
+    TraceRecorder::get().stop();
+  }) == 0;
+}
+
+void TraceRecorder::stop() noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (recording_.load(std::memory_order_relaxed) == false) {
+    return;
+  }
+  recording_.store(false, std::memory_order_relaxed);
+
+  writeBuffer();
+  file_.close();
+}
+
+void TraceRecorder::record(const CallSite         &site,
+                           Severity                severity,
+                           std::string_view        messageFormat,
+                           const detail::Argument *arguments,
+                           std::size_t             count) noexcept {
+  // arguments are printed without lock, only their sizes are needed
+  thread_local CountingStreamBuffer counter;
+  thread_local std::ostream         stream{&counter};
+
+  std::uint32_t sizes[maxTraceArguments];
+  std::size_t   printed = std::min(count, maxTraceArguments);
+  for (std::size_t i = 0; i < printed; ++i) {
+    arguments[i].print(stream, arguments[i].value);
+    sizes[i] = counter.takeSize();
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (recording_.load(std::memory_order_relaxed) == false) {
+    return;
+  }
+
+  auto [foundSite, newSite] = sites_.emplace(&site, sites_.size());
+  if (newSite) {
+    buffer_ += 'S';
+    appendNumber(buffer_, foundSite->second);
+    appendString(buffer_, site.fileName);
+    appendNumber(buffer_, site.lineNumber);
+    appendString(buffer_, site.functionName);
+    appendString(buffer_, messageFormat);
+  }
+  auto foundThread =
+      threads_.emplace(std::this_thread::get_id(), threads_.size()).first;
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  buffer_ += 'E';
+  appendNumber(buffer_, foundSite->second);
+  appendNumber(buffer_, static_cast<int>(severity));
+  appendNumber(buffer_, foundThread->second);
+  appendNumber(buffer_,
+               std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_)
+                   .count());
+  appendNumber(buffer_, printed);
+  for (std::size_t i = 0; i < printed; ++i) {
+    buffer_ += static_cast<char>(arguments[i].kind);
+    appendNumber(buffer_, sizes[i]);
+  }
+  last_ = now;
+
+  if (buffer_.size() >= traceBufferSize) {
+    writeBuffer();
+  }
+}
+
+TraceRecorder &TraceRecorder::get() noexcept {
+  // never destroyed: records can be logged while static objects are destroyed
+  static TraceRecorder &recorder = *new TraceRecorder;
+  return recorder;
+}
+
+void TraceRecorder::writeBuffer() noexcept {
+  file_.write(buffer_.data(), buffer_.size());
+  file_.flush();
+  buffer_.clear();
+}
+
+TraceReader::TraceReader(const std::string &fileName) noexcept(false)
+    : file_{fileName, std::ios::binary}
+    , time_{0} {
+  if (file_.is_open() == false) {
+    throw std::runtime_error{"can not open trace file: " + fileName};
+  }
+
+  char magic[traceMagic.size()];
+  if (file_.read(magic, sizeof(magic)).fail() ||
+      std::string_view{magic, sizeof(magic)} != traceMagic) {
+    throw std::runtime_error{"file is not trace: " + fileName};
+  }
+}
+
+bool TraceReader::next(TraceEvent &event) noexcept(false) {
+  int tag = file_.get();
+  for (; tag != std::ifstream::traits_type::eof(); tag = file_.get()) {
+    if (tag == 'S') {
+      TraceSite site;
+      if (readNumber(file_) != sites_.size()) {
+        throw std::runtime_error{"invalid id of call site in trace"};
+      }
+      site.fileName      = readString(file_);
+      site.lineNumber    = readNumber(file_);
+      site.functionName  = readString(file_);
+      site.messageFormat = readString(file_);
+      sites_.emplace_back(std::move(site));
+    } else if (tag == 'E') {
+      event.site = readNumber(file_);
+      if (event.site >= sites_.size()) {
+        throw std::runtime_error{"unknown call site in trace"};
+      }
+      std::uint64_t severity = readNumber(file_);
+      if (severity > static_cast<std::uint64_t>(Severity::Failure)) {
+        throw std::runtime_error{"invalid severity in trace"};
+      }
+      event.severity = static_cast<Severity>(severity);
+      event.thread   = readNumber(file_);
+      time_ += std::chrono::nanoseconds{readNumber(file_)};
+      event.time = time_;
+      std::uint64_t count = readNumber(file_);
+      if (count > maxTraceArguments) {
+        throw std::runtime_error{"invalid count of arguments in trace"};
+      }
+      event.arguments.resize(count);
+      for (TraceArgument &argument : event.arguments) {
+        int kind = file_.get();
+        if (kind < 0 ||
+            kind > static_cast<int>(detail::ArgumentKind::Streamed)) {
+          throw std::runtime_error{"invalid kind of argument in trace"};
+        }
+        argument.kind = static_cast<detail::ArgumentKind>(kind);
+        argument.size = readNumber(file_);
+      }
+      return true;
+    } else {
+      throw std::runtime_error{"invalid entry in trace"};
+    }
+  }
+  return false;
+}
+} // namespace logs
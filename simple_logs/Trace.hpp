@@ -0,0 +1,143 @@
+// Trace.hpp
+/**\file
+ * Capturing of logging workload. Trace is a compact binary file, which
+ * contains for every call of logging macro its call site, severity, thread,
+ * time since start of capturing and kinds and printed sizes of arguments.
+ * Values of arguments are not stored, so trace can be taken from production.
+ *
+ * ```cpp
+ * logs::TraceRecorder::get().start("app.trace");
+ * ```
+ *
+ * The trace can be replayed against any configuration of logger by
+ * `logs_replay` tool.
+ *
+ * Format of the file: magic `LOGSTRC1` and sequence of entries. Integers are
+ * stored as unsigned LEB128, strings as length and characters.
+ *
+ * - `S` - definition of call site: id, file name, line, function name and
+ * format of message. Site is defined before its first event
+ * - `E` - call of logging macro: id of site, severity, id of thread,
+ * nanoseconds since previous event, count of arguments and kind and size of
+ * every argument
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <simple_logs/LogsFront.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace logs {
+/**\brief call site of logging macro in trace
+ */
+struct TraceSite {
+  std::string fileName;
+  int         lineNumber;
+  std::string functionName;
+  std::string messageFormat;
+};
+
+struct TraceArgument {
+  detail::ArgumentKind kind;
+  /// count of characters of printed argument
+  std::uint32_t        size;
+};
+
+/**\brief call of logging macro in trace
+ */
+struct TraceEvent {
+  /// index in `TraceReader::getSites`
+  std::uint32_t              site;
+  Severity                   severity;
+  /// threads are numbered from 0 in order of their first record
+  std::uint32_t              thread;
+  /// time since start of capturing
+  std::chrono::nanoseconds   time;
+  std::vector<TraceArgument> arguments;
+};
+
+/**\brief writes trace of all logging macroses of the process
+ */
+class TraceRecorder {
+public:
+  /**\brief start capturing to the file, previous capturing is stopped. The
+   * file is closed by `stop` or at exit of program
+   * \throw exception if the file can not be opened
+   */
+  void start(const std::string &fileName) noexcept(false);
+
+  void stop() noexcept;
+
+  bool isRecording() const noexcept {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  /**\brief add call of logging macro to the trace, called by logging macroses
+   * \note uses mutex, so it is slow
+   */
+  void record(const CallSite         &site,
+              Severity                severity,
+              std::string_view        messageFormat,
+              const detail::Argument *arguments,
+              std::size_t             count) noexcept;
+
+  static TraceRecorder &get() noexcept;
+
+private:
+  TraceRecorder() noexcept
+      : recording_{false} {
+  }
+
+  TraceRecorder(const TraceRecorder &) = delete;
+  TraceRecorder(TraceRecorder &&)      = delete;
+
+  void writeBuffer() noexcept;
+
+private:
+  std::atomic_bool                                    recording_;
+  std::mutex                                          mutex_;
+  std::ofstream                                       file_;
+  /// encoded entries, which are not written yet
+  std::string                                         buffer_;
+  std::unordered_map<const CallSite *, std::uint32_t> sites_;
+  std::map<std::thread::id, std::uint32_t>            threads_;
+  /// time of previous event
+  std::chrono::steady_clock::time_point               last_;
+};
+
+/**\brief reads trace, which was written by `TraceRecorder`
+ */
+class TraceReader {
+public:
+  /**\throw exception if the file can not be opened or it is not trace
+   */
+  explicit TraceReader(const std::string &fileName) noexcept(false);
+
+  /**\brief read next event
+   * \return false at end of trace
+   * \throw exception if the trace is corrupted
+   */
+  bool next(TraceEvent &event) noexcept(false);
+
+  /**\return call sites, which were read before
+   */
+  const std::vector<TraceSite> &getSites() const noexcept {
+    return sites_;
+  }
+
+private:
+  std::ifstream            file_;
+  std::vector<TraceSite>   sites_;
+  /// time of previous event
+  std::chrono::nanoseconds time_;
+};
+} // namespace logs
@@ -0,0 +1,1499 @@
+// logs.cpp
+
+#include "logs.hpp"
+#include "AppendStreamBuffer.hpp"
+#include "ContentFilter.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iterator>
+#include <pthread.h>
+#include <sstream>
+#include <unistd.h>
+#include <utility>
+
+namespace std {
+std::ostream &
+operator<<(std::ostream &stream,
+           const std::chrono::time_point<std::chrono::system_clock>
+               &timePoint) noexcept {
+  std::time_t t = std::chrono::system_clock::to_time_t(timePoint);
+  stream << std::put_time(std::localtime(&t), "%c");
+  return stream;
+}
+
+std::ostream &operator<<(std::ostream &stream, logs::Severity sev) {
+  stream << logs::toString(sev);
+  return stream;
+}
+} // namespace std
+
+namespace logs {
+namespace detail {
+/// origin of record, which is formatting in current thread by writer thread
+thread_local const RecordOrigin *currentOrigin = nullptr;
+
+/// call site of record, which is formatting in current thread
+thread_local CallSite *currentSite = nullptr;
+
+/**\brief message of record, which is formatting in current thread. It is
+ * rendered at first use and shared by all sinks of the record
+ */
+struct CurrentMessage {
+  const boost::format *message  = nullptr;
+  bool                 rendered = false;
+  std::string          text;
+};
+
+thread_local CurrentMessage currentMessage;
+
+/**\brief set record, which is formatting in current thread
+ */
+void setCurrentRecord(CallSite *site, const boost::format *message) noexcept {
+  currentSite             = site;
+  currentMessage.message  = message;
+  currentMessage.rendered = false;
+}
+
+/**\brief runs of call site items of the layout rendered for the call site
+ */
+struct LayoutCache {
+  std::uint64_t            layoutId;
+  std::vector<std::string> runs;
+  LayoutCache             *next;
+};
+} // namespace detail
+
+boost::format getLogFormat(std::string_view format) noexcept {
+  boost::format retval{std::string{format}};
+  retval.exceptions(boost::io::all_error_bits ^ (boost::io::too_few_args_bit |
+                                                 boost::io::too_many_args_bit));
+  return retval;
+}
+
+std::chrono::system_clock::time_point recordTime() noexcept {
+  if (detail::currentOrigin != nullptr) {
+    return detail::currentOrigin->time;
+  }
+  return std::chrono::system_clock::now();
+}
+
+std::thread::id recordThreadId() noexcept {
+  if (detail::currentOrigin != nullptr) {
+    return detail::currentOrigin->threadId;
+  }
+  return std::this_thread::get_id();
+}
+
+CallSite *recordSite() noexcept {
+  return detail::currentSite;
+}
+
+std::string_view recordText(const boost::format &message) noexcept {
+  detail::CurrentMessage &current = detail::currentMessage;
+  if (current.message != &message) {
+    // message of other record isn't cached
+    thread_local std::string text;
+    text = message.str();
+    return text;
+  }
+
+  if (current.rendered == false) {
+    current.text     = message.str();
+    current.rendered = true;
+  }
+  return current.text;
+}
+
+void appendMessage(RecordBuffer        &output,
+                   const boost::format &message) noexcept {
+  const detail::CurrentMessage &current = detail::currentMessage;
+  if (current.message == &message && current.rendered) {
+    output.append(current.text);
+    return;
+  }
+
+  thread_local detail::AppendStreamBuffer<RecordBuffer> buffer;
+  thread_local std::ostream stream{&buffer};
+
+  buffer.setOutput(&output);
+  stream << message;
+  buffer.setOutput(nullptr);
+}
+
+void appendTime(RecordBuffer                         &output,
+                std::chrono::system_clock::time_point timePoint) noexcept {
+  thread_local std::time_t cachedTime = -1;
+  thread_local char        cachedString[64];
+  thread_local std::size_t cachedSize = 0;
+
+  std::time_t t = std::chrono::system_clock::to_time_t(timePoint);
+  if (t != cachedTime) {
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    cachedSize = std::strftime(cachedString, sizeof(cachedString), "%c", &tm);
+    cachedTime = t;
+  }
+  output.append(cachedString, cachedSize);
+}
+
+void appendThreadId(RecordBuffer &output, std::thread::id id) noexcept {
+  thread_local std::thread::id cachedId;
+  thread_local std::string     cachedString;
+
+  if (id != cachedId || cachedString.empty()) {
+    std::ostringstream stream;
+    stream << id;
+    cachedString = stream.str();
+    cachedId     = id;
+  }
+  output.append(cachedString);
+}
+
+Layout::Layout(std::string_view layout) noexcept(false)
+    : id_{detail::internKey(layout)}
+    , hasSiteItems_{false} {
+  std::string text;
+  for (std::size_t i = 0; i < layout.size(); ++i) {
+    if (layout[i] != '%') {
+      text += layout[i];
+      continue;
+    }
+
+    std::size_t end = layout.find('%', i + 1);
+    if (end == std::string_view::npos) {
+      throw std::invalid_argument{"invalid log layout: " +
+                                  std::string{layout}};
+    }
+    if (end == i + 1) { // %% is escaped %
+      text += '%';
+      i = end;
+      continue;
+    }
+
+    std::string_view number = layout.substr(i + 1, end - i - 1);
+    if (number.size() != 1 || number[0] < '1' || number[0] > '7') {
+      throw std::invalid_argument{"invalid item of log layout: " +
+                                  std::string{number}};
+    }
+
+    if (text.empty() == false) {
+      segments_.emplace_back(Segment{Text, std::move(text)});
+      text.clear();
+    }
+    segments_.emplace_back(
+        Segment{static_cast<Item>(number[0] - '0'), std::string{}});
+    i = end;
+  }
+
+  if (text.empty() == false) {
+    segments_.emplace_back(Segment{Text, std::move(text)});
+  }
+
+  hasSiteItems_ = hasItem(FileNameItem) || hasItem(LineNumberItem) ||
+                  hasItem(FunctionNameItem);
+}
+
+bool Layout::hasItem(Item item) const noexcept {
+  return std::any_of(segments_.begin(),
+                     segments_.end(),
+                     [item](const Segment &segment) {
+                       return segment.item == item;
+                     });
+}
+
+void Layout::render(RecordBuffer        &output,
+                    Severity             severity,
+                    std::string_view     fileName,
+                    int                  lineNumber,
+                    std::string_view     functionName,
+                    const boost::format &message) const noexcept {
+  CallSite *site = detail::currentSite;
+  if (site == nullptr || hasSiteItems_ == false) {
+    for (const Segment &segment : segments_) {
+      renderSegment(output,
+                    segment,
+                    severity,
+                    fileName,
+                    lineNumber,
+                    functionName,
+                    message);
+    }
+    return;
+  }
+
+  const detail::LayoutCache &cache = getCache(*site);
+  std::size_t                run   = 0;
+  for (std::size_t i = 0; i < segments_.size();) {
+    if (isSiteItem(segments_[i].item) == false) {
+      renderSegment(output,
+                    segments_[i],
+                    severity,
+                    fileName,
+                    lineNumber,
+                    functionName,
+                    message);
+      ++i;
+      continue;
+    }
+
+    output.append(cache.runs[run++]);
+    while (i < segments_.size() && isSiteItem(segments_[i].item)) {
+      ++i;
+    }
+  }
+}
+
+bool Layout::isSiteItem(Item item) noexcept {
+  return item == Text || item == FileNameItem || item == LineNumberItem ||
+         item == FunctionNameItem;
+}
+
+void Layout::renderSegment(RecordBuffer        &output,
+                           const Segment       &segment,
+                           Severity             severity,
+                           std::string_view     fileName,
+                           int                  lineNumber,
+                           std::string_view     functionName,
+                           const boost::format &message) const noexcept {
+  switch (segment.item) {
+  case Text:
+    output.append(segment.text);
+    break;
+  case SeverityItem:
+    output.append(toString(severity));
+    break;
+  case FileNameItem:
+    output.append(fileName);
+    break;
+  case LineNumberItem: {
+    char buffer[16];
+    auto result =
+        std::to_chars(std::begin(buffer), std::end(buffer), lineNumber);
+    output.append(buffer, result.ptr);
+    break;
+  }
+  case FunctionNameItem:
+    output.append(functionName);
+    break;
+  case TimePointItem:
+    appendTime(output, recordTime());
+    break;
+  case ThreadIdItem:
+    appendThreadId(output, recordThreadId());
+    break;
+  case MessageItem:
+    appendMessage(output, message);
+    break;
+  }
+}
+
+const detail::LayoutCache &Layout::getCache(CallSite &site) const noexcept {
+  detail::LayoutCache *head = site.layoutCaches.load(std::memory_order_acquire);
+  for (detail::LayoutCache *cache = head; cache != nullptr;
+       cache                      = cache->next) {
+    if (cache->layoutId == id_) {
+      return *cache;
+    }
+  }
+
+  // never deleted, because call sites are static, and count of caches is
+  // limited by count of different layouts. If several threads create cache at
+  // same time, then all of them are added, but only first is used
+  auto *cache = new detail::LayoutCache{id_, {}, head};
+  for (std::size_t i = 0; i < segments_.size();) {
+    if (isSiteItem(segments_[i].item) == false) {
+      ++i;
+      continue;
+    }
+
+    RecordBuffer run;
+    for (; i < segments_.size() && isSiteItem(segments_[i].item); ++i) {
+      renderSegment(run,
+                    segments_[i],
+                    Severity::Placeholder,
+                    site.fileName,
+                    site.lineNumber,
+                    site.functionName,
+                    boost::format{});
+    }
+    cache->runs.emplace_back(run);
+  }
+
+  while (site.layoutCaches.compare_exchange_weak(cache->next,
+                                                 cache,
+                                                 std::memory_order_release,
+                                                 std::memory_order_acquire) ==
+         false) {
+  }
+  return *cache;
+}
+
+BasicFrontend::BasicFrontend()
+    : filter_{nullptr}
+    , severities_{0}
+    , channels_{allChannels} {
+  setFilter(Severity::Placeholder >= Severity::Trace);
+}
+
+bool BasicFrontend::acceptContent(CallSite            *site,
+                                  std::string_view     fileName,
+                                  std::string_view     functionName,
+                                  const boost::format &message) const noexcept {
+  return contentFilter_->isAccepted(site, fileName, functionName, message);
+}
+
+void BasicFrontend::formatRecord(RecordBuffer        &buffer,
+                                 Severity             severity,
+                                 std::string_view     fileName,
+                                 int                  lineNumber,
+                                 std::string_view     functionName,
+                                 const boost::format &message) const noexcept {
+  buffer.append(
+      makeRecord(severity, fileName, lineNumber, functionName, message));
+}
+
+void BasicFrontend::setFilter(SeverityPredicat filter) noexcept(false) {
+  if (filter == false) {
+    throw std::invalid_argument{"invalid severity filter"};
+  }
+
+  std::uint32_t severities = 0;
+  for (int i = static_cast<int>(Severity::Trace);
+       i <= static_cast<int>(Severity::Failure);
+       ++i) {
+    if (filter(static_cast<Severity>(i))) {
+      severities |= 1u << i;
+    }
+  }
+
+  filter_     = std::move(filter);
+  severities_ = severities;
+  SimpleLogger::get().updateAccepted(*this);
+}
+
+void BasicFrontend::setChannels(Channels channels) noexcept {
+  channels_ = channels;
+  SimpleLogger::get().updateAccepted(*this);
+}
+
+std::string LayoutFrontend::makeRecord(Severity         severity,
+                                       std::string_view fileName,
+                                       int              lineNumber,
+                                       std::string_view functionName,
+                                       boost::format message) const noexcept {
+  RecordBuffer buffer;
+  formatRecord(buffer, severity, fileName, lineNumber, functionName, message);
+  return std::string{buffer};
+}
+
+void LayoutFrontend::formatRecord(RecordBuffer        &buffer,
+                                  Severity             severity,
+                                  std::string_view     fileName,
+                                  int                  lineNumber,
+                                  std::string_view     functionName,
+                                  const boost::format &message) const noexcept {
+  getLayout().render(
+      buffer, severity, fileName, lineNumber, functionName, message);
+}
+
+const Layout &StandardFrontend::getLayout() const noexcept {
+  // never destroyed: asynchronous writer can format records at exit
+  static const Layout &layout = *new Layout{STANDARD_LOG_FORMAT};
+  return layout;
+}
+
+const Layout &LightFrontend::getLayout() const noexcept {
+  // never destroyed: asynchronous writer can format records at exit
+  static const Layout &layout = *new Layout{LIGHT_LOG_FORMAT};
+  return layout;
+}
+
+void TextStreamBackend::consume(std::string_view record) noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  stream_ << record << std::endl;
+}
+
+void TextStreamBackend::consumeBatch(const std::string_view *records,
+                                     std::size_t             count) noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (std::size_t i = 0; i < count; ++i) {
+    stream_ << records[i] << '\n';
+  }
+}
+
+void TextStreamBackend::flush() noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  stream_.flush();
+}
+
+void TextStreamBackend::lockForFork() noexcept {
+  mutex_.lock();
+  // otherwise buffered records are written by both processes
+  stream_.flush();
+}
+
+void TextStreamBackend::unlockAfterFork(bool) noexcept {
+  mutex_.unlock();
+}
+
+FileBackend::FileBackend(std::string fileName,
+                         std::size_t maxSize,
+                         std::size_t maxFiles) noexcept(false)
+    : baseName_{std::move(fileName)}
+    , fileName_{baseName_}
+    , maxSize_{maxSize}
+    , maxFiles_{maxFiles}
+    , size_{0}
+    , separateChildFiles_{false} {
+  open();
+  if (stream_.is_open() == false) {
+    throw std::runtime_error{"can not open log file: " + fileName_};
+  }
+}
+
+void FileBackend::consume(std::string_view record) noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  stream_ << record << std::endl;
+
+  size_ += record.size() + 1;
+  if (maxSize_ != 0 && size_ >= maxSize_) {
+    rotate();
+  }
+}
+
+void FileBackend::consumeBatch(const std::string_view *records,
+                               std::size_t             count) noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (std::size_t i = 0; i < count; ++i) {
+    stream_ << records[i] << '\n';
+
+    size_ += records[i].size() + 1;
+    if (maxSize_ != 0 && size_ >= maxSize_) {
+      rotate();
+    }
+  }
+}
+
+void FileBackend::flush() noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  stream_.flush();
+}
+
+void FileBackend::lockForFork() noexcept {
+  mutex_.lock();
+  stream_.flush();
+}
+
+void FileBackend::unlockAfterFork(bool child) noexcept {
+  if (child && separateChildFiles_) {
+    stream_.close();
+    // child of child gets own file too, not file of its parent with suffix
+    fileName_ = baseName_ + '.' + std::to_string(getpid());
+    open();
+  }
+  mutex_.unlock();
+}
+
+void FileBackend::open() noexcept {
+  stream_.open(fileName_, std::ios::out | std::ios::app | std::ios::ate);
+  std::streamoff pos = stream_.tellp();
+  size_              = pos > 0 ? static_cast<std::size_t>(pos) : 0;
+}
+
+void FileBackend::rotate() noexcept {
+  stream_.close();
+
+  if (maxFiles_ == 0) {
+    std::remove(fileName_.c_str());
+  } else {
+    for (std::size_t i = maxFiles_; i > 1; --i) {
+      std::rename((fileName_ + '.' + std::to_string(i - 1)).c_str(),
+                  (fileName_ + '.' + std::to_string(i)).c_str());
+    }
+    std::rename(fileName_.c_str(), (fileName_ + ".1").c_str());
+  }
+
+  open();
+}
+
+RecordArena &RecordArena::local() noexcept {
+  thread_local RecordArena arena;
+  return arena;
+}
+
+/// true in writer thread of AsyncQueue and in threads of its FanOutPool
+static thread_local bool insideWriter = false;
+
+FanOutPool::FanOutPool(std::size_t threads) noexcept(false)
+    : tasks_{nullptr}
+    , next_{0}
+    , remaining_{0}
+    , generation_{0}
+    , stopped_{false} {
+  for (std::size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back(&FanOutPool::work, this);
+  }
+}
+
+FanOutPool::~FanOutPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopped_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+}
+
+void FanOutPool::run(std::vector<Task> &tasks) noexcept {
+  if (tasks.empty()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    tasks_     = &tasks;
+    next_      = 0;
+    remaining_ = tasks.size();
+    ++generation_;
+  }
+  cv_.notify_all();
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  runTasks(lock);
+  doneCv_.wait(lock, [this]() {
+    return remaining_ == 0;
+  });
+  tasks_ = nullptr;
+}
+
+void FanOutPool::runTasks(std::unique_lock<std::mutex> &lock) noexcept {
+  while (tasks_ != nullptr && next_ < tasks_->size()) {
+    Task &task = (*tasks_)[next_++];
+    lock.unlock();
+    task();
+    lock.lock();
+
+    if (--remaining_ == 0) {
+      doneCv_.notify_all();
+    }
+  }
+}
+
+void FanOutPool::work() noexcept {
+  insideWriter = true;
+
+  std::uint64_t                generation = 0;
+  std::unique_lock<std::mutex> lock{mutex_};
+  for (;;) {
+    cv_.wait(lock, [this, generation]() {
+      return generation_ != generation || stopped_;
+    });
+    if (stopped_) {
+      return;
+    }
+
+    generation = generation_;
+    runTasks(lock);
+  }
+}
+
+AsyncQueue::AsyncQueue() noexcept
+    : running_{false}
+    , sequence_{0}
+    , written_{0}
+    , urgentCount_{0}
+    , regularCount_{0}
+    , flushRequested_{false} {
+}
+
+AsyncQueue::~AsyncQueue() {
+  stop();
+}
+
+void AsyncQueue::start(AsyncSettings settings, Writer writer) noexcept(false) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  settings_ = settings;
+  if (thread_.joinable()) {
+    cv_.notify_one();
+    return;
+  }
+
+  writer_ = std::move(writer);
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread{&AsyncQueue::run, this};
+}
+
+void AsyncQueue::stop() noexcept {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (thread_.joinable() == false) {
+      return;
+    }
+    running_.store(false, std::memory_order_release);
+    cv_.notify_one();
+  }
+
+  thread_.join();
+  thread_ = std::thread{};
+}
+
+void AsyncQueue::flush(std::uint64_t sequence) noexcept {
+  std::unique_lock<std::mutex> lock{mutex_};
+  std::uint64_t                target = std::min(sequence, sequence_);
+  if (running_.load(std::memory_order_relaxed) == false ||
+      written_ >= target) {
+    return;
+  }
+
+  flushRequested_ = true;
+  cv_.notify_one();
+  writtenCv_.wait(lock, [this, target]() {
+    return written_ >= target ||
+           running_.load(std::memory_order_relaxed) == false;
+  });
+}
+
+std::uint64_t AsyncQueue::push(AsyncRecord &&record) noexcept {
+  std::unique_lock<std::mutex> lock{mutex_};
+  if (running_.load(std::memory_order_relaxed) == false) {
+    return 0;
+  }
+
+  bool          wakeUp   = enqueue(std::move(record));
+  std::uint64_t sequence = sequence_;
+  lock.unlock();
+  if (wakeUp) {
+    cv_.notify_one();
+  }
+  return sequence;
+}
+
+std::uint64_t AsyncQueue::push(std::vector<AsyncRecord> &records) noexcept {
+  std::unique_lock<std::mutex> lock{mutex_};
+  if (running_.load(std::memory_order_relaxed) == false) {
+    return 0;
+  }
+
+  bool wakeUp = false;
+  for (AsyncRecord &record : records) {
+    wakeUp |= enqueue(std::move(record));
+  }
+
+  std::uint64_t sequence = sequence_;
+  lock.unlock();
+  if (wakeUp) {
+    cv_.notify_one();
+  }
+  return sequence;
+}
+
+bool AsyncQueue::enqueue(AsyncRecord &&record) noexcept {
+  record.sequence = ++sequence_;
+  bool urgent     = isUrgent(record.severity);
+  lanes_[static_cast<int>(record.severity)].emplace_back(std::move(record));
+
+  if (urgent) {
+    return ++urgentCount_ == 1;
+  }
+  ++regularCount_;
+  if (regularCount_ == 1) {
+    batchStart_ = std::chrono::steady_clock::now();
+    return true;
+  }
+  return regularCount_ == settings_.batchSize;
+}
+
+void AsyncQueue::lockForFork() noexcept {
+  mutex_.lock();
+}
+
+void AsyncQueue::unlockAfterFork(bool child) noexcept {
+  if (child == false) {
+    mutex_.unlock();
+    return;
+  }
+
+  // records of parent are written by parent
+  for (std::vector<AsyncRecord> &lane : lanes_) {
+    lane.clear();
+  }
+  written_        = sequence_;
+  urgentCount_    = 0;
+  regularCount_   = 0;
+  flushRequested_ = false;
+  reinitializeAfterFork(cv_);
+  reinitializeAfterFork(writtenCv_);
+  // writer thread doesn't exist in child, so it can not be joined
+  reinitializeAfterFork(thread_);
+
+  bool restart = running_.load(std::memory_order_relaxed);
+  running_.store(false, std::memory_order_release);
+  mutex_.unlock();
+
+  if (restart) {
+    try {
+      start(settings_, writer_);
+    } catch (std::exception &) {
+      // records are written synchronously
+    }
+  }
+}
+
+bool AsyncQueue::isWriterThread() noexcept {
+  return insideWriter;
+}
+
+bool AsyncQueue::isBatchReady() const noexcept {
+  return regularCount_ != 0 &&
+         (regularCount_ >= settings_.batchSize ||
+          std::chrono::steady_clock::now() >=
+              batchStart_ + settings_.batchDelay);
+}
+
+static void takeLane(std::vector<AsyncRecord> &lane,
+                     std::vector<AsyncRecord> &records) noexcept {
+  std::move(lane.begin(), lane.end(), std::back_inserter(records));
+  lane.clear();
+}
+
+void AsyncQueue::run() noexcept {
+  insideWriter = true;
+
+  std::vector<AsyncRecord>     records;
+  std::unique_ptr<FanOutPool>  pool;
+  std::unique_lock<std::mutex> lock{mutex_};
+  for (;;) {
+    auto isReady = [this]() {
+      return urgentCount_ != 0 || isBatchReady() || flushRequested_ ||
+             running_.load(std::memory_order_relaxed) == false;
+    };
+
+    if (regularCount_ == 0) {
+      cv_.wait(lock, [this, &isReady]() {
+        return regularCount_ != 0 || isReady();
+      });
+    }
+    if (isReady() == false) {
+      cv_.wait_until(lock, batchStart_ + settings_.batchDelay, isReady);
+    }
+
+    bool drainAll = settings_.keepOrder || isBatchReady() || flushRequested_ ||
+                    running_.load(std::memory_order_relaxed) == false;
+
+    // urgent lanes first, from the most important severity
+    for (int i = static_cast<int>(lanes_.size()) - 1; i >= 0; --i) {
+      if (isUrgent(static_cast<Severity>(i))) {
+        takeLane(lanes_[i], records);
+      }
+    }
+    std::size_t urgentTaken = records.size();
+    if (drainAll) {
+      for (std::vector<AsyncRecord> &lane : lanes_) {
+        takeLane(lane, records);
+      }
+    }
+
+    auto byOrder = [](const AsyncRecord &lhs, const AsyncRecord &rhs) {
+      return lhs.sequence < rhs.sequence;
+    };
+    if (settings_.keepOrder) {
+      std::sort(records.begin(), records.end(), byOrder);
+    } else {
+      std::sort(records.begin() + urgentTaken, records.end(), byOrder);
+    }
+
+    std::uint64_t taken = sequence_;
+    urgentCount_        = 0;
+    if (drainAll) {
+      regularCount_   = 0;
+      flushRequested_ = false;
+    }
+
+    std::size_t fanOutThreads = settings_.fanOutThreads;
+    lock.unlock();
+
+    if (fanOutThreads == 0) {
+      pool.reset();
+    } else if (pool == nullptr || pool->getThreadCount() != fanOutThreads) {
+      pool.reset();
+      pool = std::make_unique<FanOutPool>(fanOutThreads);
+    }
+
+    if (records.empty() == false) {
+      writer_(records, pool.get());
+    }
+    records.clear();
+
+    lock.lock();
+    if (drainAll) {
+      written_ = taken;
+      writtenCv_.notify_all();
+
+      if (running_.load(std::memory_order_relaxed) == false) {
+        return;
+      }
+    }
+  }
+}
+
+void SimpleLogger::log(Severity         severity,
+                       std::string_view fileName,
+                       int              lineNumber,
+                       std::string_view functionName,
+                       boost::format    message) noexcept {
+  doLog(nullptr,
+        severity,
+        fileName,
+        lineNumber,
+        functionName,
+        std::move(message),
+        nullptr);
+}
+
+void SimpleLogger::log(CallSite     &site,
+                       Severity      severity,
+                       boost::format message) noexcept {
+  doLog(&site,
+        severity,
+        site.fileName,
+        site.lineNumber,
+        site.functionName,
+        std::move(message),
+        nullptr);
+}
+
+void SimpleLogger::log(CallSite           &site,
+                       Severity            severity,
+                       boost::format       message,
+                       const RecordOrigin &origin) noexcept {
+  doLog(&site,
+        severity,
+        site.fileName,
+        site.lineNumber,
+        site.functionName,
+        std::move(message),
+        &origin);
+}
+
+void SimpleLogger::log(std::vector<AsyncRecord> &records) noexcept {
+  if (queue_.isRunning()) {
+    std::uint32_t synchronous = synchronous_.load(std::memory_order_relaxed);
+    bool          urgent      = std::any_of(
+        records.begin(), records.end(), [synchronous](const auto &record) {
+          return synchronous & (1u << static_cast<int>(record.severity));
+        });
+
+    if (std::uint64_t sequence = queue_.push(records)) {
+      std::uint64_t &lastQueued = lastQueuedSequence();
+      lastQueued                = sequence;
+      if (urgent) {
+        queue_.flush(sequence);
+        lastQueued = 0;
+      }
+      records.clear();
+      return;
+    }
+  }
+
+  write(records);
+  records.clear();
+}
+
+void SimpleLogger::doLog(CallSite           *site,
+                         Severity            severity,
+                         std::string_view    fileName,
+                         int                 lineNumber,
+                         std::string_view    functionName,
+                         boost::format       message,
+                         const RecordOrigin *origin) noexcept {
+  if (queue_.isRunning()) {
+    Channels channel = site != nullptr ? site->channel : defaultChannel;
+    if (isAccepted(severity, channel) == false) {
+      return;
+    }
+
+    std::uint64_t &lastQueued = lastQueuedSequence();
+    if (synchronous_.load(std::memory_order_relaxed) &
+        (1u << static_cast<int>(severity))) {
+      // records of current thread must be written in order of logging
+      if (lastQueued != 0) {
+        queue_.flush(lastQueued);
+        lastQueued = 0;
+      }
+
+      detail::currentOrigin = origin;
+      write(site, severity, fileName, lineNumber, functionName, message, true);
+      detail::currentOrigin = nullptr;
+      return;
+    }
+
+    AsyncRecord record{0,
+                       severity,
+                       fileName,
+                       lineNumber,
+                       functionName,
+                       origin != nullptr
+                           ? *origin
+                           : RecordOrigin{std::chrono::system_clock::now(),
+                                          std::this_thread::get_id()},
+                       site,
+                       std::move(message)};
+    if (std::uint64_t sequence = queue_.push(std::move(record))) {
+      lastQueued = sequence;
+      return;
+    }
+    message = std::move(record.message);
+  }
+
+  detail::currentOrigin = origin;
+  write(site, severity, fileName, lineNumber, functionName, message);
+  detail::currentOrigin = nullptr;
+}
+
+/**\return bits of severities, which satisfy the predicate, 0 for empty one
+ */
+static std::uint32_t toSeverityMask(SeverityPredicat predicate) noexcept {
+  std::uint32_t mask = 0;
+  if (predicate) {
+    for (int i = static_cast<int>(Severity::Trace);
+         i <= static_cast<int>(Severity::Failure);
+         ++i) {
+      if (predicate(static_cast<Severity>(i))) {
+        mask |= 1u << i;
+      }
+    }
+  }
+  return mask;
+}
+
+void SimpleLogger::setAsync(AsyncSettings settings) noexcept(false) {
+  synchronous_.store(toSeverityMask(settings.synchronous),
+                     std::memory_order_relaxed);
+  startQueue(settings);
+}
+
+void SimpleLogger::startQueue(const AsyncSettings &settings) noexcept(false) {
+  queue_.start(settings,
+               [this](const std::vector<AsyncRecord> &records,
+                      FanOutPool                     *pool) {
+                 if (pool == nullptr) {
+                   write(records);
+                 } else {
+                   write(records, *pool);
+                 }
+               });
+}
+
+void SimpleLogger::addSink(Sink sink) noexcept(false) {
+  checkSink(sink);
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto sinks = std::make_shared<SinkList>(*sinks_);
+  sinks->emplace_back(std::move(sink));
+  sinks_ = std::move(sinks);
+  version_.fetch_add(1, std::memory_order_release);
+  updateAccepted(*sinks_);
+}
+
+void SimpleLogger::setSinks(SinkList sinks) noexcept(false) {
+  for (const Sink &sink : sinks) {
+    checkSink(sink);
+  }
+  replaceSinks(std::make_shared<const SinkList>(std::move(sinks)),
+               std::nullopt);
+}
+
+void SimpleLogger::configure(SinkList                     sinks,
+                             std::optional<AsyncSettings> async) noexcept(
+    false) {
+  for (const Sink &sink : sinks) {
+    checkSink(sink);
+  }
+  auto current = std::make_shared<const SinkList>(std::move(sinks));
+
+  // the thread is started before changing of sinks, because it can fail
+  std::uint32_t synchronous = 0;
+  if (async) {
+    synchronous = toSeverityMask(async->synchronous);
+    startQueue(*async);
+  }
+  replaceSinks(std::move(current), synchronous);
+  if (async == std::nullopt) {
+    queue_.stop();
+  }
+}
+
+void SimpleLogger::replaceSinks(
+    std::shared_ptr<const SinkList> current,
+    std::optional<std::uint32_t>    synchronous) noexcept {
+  std::shared_ptr<const SinkList> previous;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    previous = std::exchange(sinks_, current);
+    version_.fetch_add(1, std::memory_order_release);
+    updateAccepted(*sinks_);
+    if (synchronous) {
+      synchronous_.store(*synchronous, std::memory_order_relaxed);
+    }
+  }
+
+  // removed frontends must not lose records, which they keep
+  SinkList removed;
+  for (const Sink &sink : *previous) {
+    if (std::none_of(current->begin(),
+                     current->end(),
+                     [&sink](const Sink &other) {
+                       return other.frontend == sink.frontend &&
+                              other.backend == sink.backend;
+                     })) {
+      removed.emplace_back(sink);
+    }
+  }
+  writePending(removed, true);
+}
+
+void SimpleLogger::flush() noexcept {
+  queue_.flush();
+  writePending(currentSinks(), false);
+}
+
+void SimpleLogger::updateAccepted(const BasicFrontend &frontend) noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (std::any_of(sinks_->begin(),
+                  sinks_->end(),
+                  [&frontend](const Sink &sink) {
+                    return sink.frontend.get() == &frontend;
+                  })) {
+    updateAccepted(*sinks_);
+  }
+}
+
+void SimpleLogger::updateAccepted(const SinkList &sinks) noexcept {
+  for (int i = 0; i <= static_cast<int>(Severity::Failure); ++i) {
+    Channels channels = 0;
+    for (const Sink &sink : sinks) {
+      if (sink.frontend->isAccepted(static_cast<Severity>(i), allChannels)) {
+        channels |= sink.frontend->getChannels();
+      }
+    }
+    accepted_[i].store(channels, std::memory_order_relaxed);
+  }
+}
+
+/**\brief set at destruction of the logger. Handlers of `pthread_atfork` can
+ * not be unregistered, so they check it
+ */
+static bool loggerDestroyed = false;
+
+SimpleLogger &SimpleLogger::get() noexcept {
+  static SimpleLogger logger;
+  return logger;
+}
+
+void SimpleLogger::prepareFork() noexcept {
+  if (loggerDestroyed) {
+    return;
+  }
+
+  SimpleLogger &logger = get();
+  // queued records of parent must not be lost or written by child. If fork is
+  // called by writer (from backend), then they are written by parent later
+  if (AsyncQueue::isWriterThread() == false) {
+    logger.queue_.flush();
+  }
+
+  logger.mutex_.lock();
+  logger.forkSinks_ = logger.sinks_;
+  logger.queue_.lockForFork();
+  for (const Sink &sink : *logger.forkSinks_) {
+    BasicBackend *backend = sink.backend.get();
+    // backend can be used by several sinks, but it is locked only once
+    if (std::find(logger.forkBackends_.begin(),
+                  logger.forkBackends_.end(),
+                  backend) == logger.forkBackends_.end()) {
+      backend->lockForFork();
+      logger.forkBackends_.emplace_back(backend);
+    }
+  }
+}
+
+void SimpleLogger::parentAfterFork() noexcept {
+  if (loggerDestroyed) {
+    return;
+  }
+
+  SimpleLogger &logger = get();
+  for (auto backend = logger.forkBackends_.rbegin();
+       backend != logger.forkBackends_.rend();
+       ++backend) {
+    (*backend)->unlockAfterFork(false);
+  }
+  logger.forkBackends_.clear();
+  logger.forkSinks_.reset();
+  logger.queue_.unlockAfterFork(false);
+  logger.mutex_.unlock();
+}
+
+void SimpleLogger::childAfterFork() noexcept {
+  if (loggerDestroyed) {
+    return;
+  }
+
+  SimpleLogger &logger = get();
+  for (auto backend = logger.forkBackends_.rbegin();
+       backend != logger.forkBackends_.rend();
+       ++backend) {
+    (*backend)->unlockAfterFork(true);
+  }
+  logger.forkBackends_.clear();
+  logger.forkSinks_.reset();
+  logger.mutex_.unlock();
+  // writer thread is started, when all locks are released
+  logger.queue_.unlockAfterFork(true);
+}
+
+SimpleLogger::SimpleLogger() noexcept
+    : sinks_{std::make_shared<const SinkList>()}
+    , version_{1}
+    , synchronous_{0}
+    , resource_{nullptr}
+    , accepted_{} {
+  pthread_atfork(&SimpleLogger::prepareFork,
+                 &SimpleLogger::parentAfterFork,
+                 &SimpleLogger::childAfterFork);
+}
+
+SimpleLogger::~SimpleLogger() {
+  queue_.stop();
+  writePending(*sinks_, true);
+  loggerDestroyed = true;
+}
+
+void SimpleLogger::write(CallSite            *site,
+                         Severity             severity,
+                         std::string_view     fileName,
+                         int                  lineNumber,
+                         std::string_view     functionName,
+                         const boost::format &message,
+                         bool                 flush) noexcept {
+  std::pmr::memory_resource *resource =
+      resource_.load(std::memory_order_relaxed);
+  Channels      channel  = site != nullptr ? site->channel : defaultChannel;
+  bool          accepted = false;
+  std::uint64_t bytes    = 0;
+  detail::setCurrentRecord(site, &message);
+  for (const Sink &sink : currentSinks()) {
+    if (sink.frontend->isAccepted(severity, channel) &&
+        sink.frontend->isContentAccepted(
+            site, fileName, functionName, message)) {
+      RecordArena *arena = nullptr;
+      if (resource == nullptr) {
+        arena = &RecordArena::local();
+      }
+
+      {
+        RecordBuffer record{arena != nullptr ? arena->acquire() : resource};
+        sink.frontend->formatRecord(record,
+                                    severity,
+                                    fileName,
+                                    lineNumber,
+                                    functionName,
+                                    message);
+        if (record.empty() == false) {
+          sink.backend->consume(record);
+          accepted = true;
+          bytes += record.size();
+        }
+      }
+
+      if (arena != nullptr) {
+        arena->release();
+      }
+      if (flush) {
+        sink.backend->flush();
+      }
+    }
+  }
+  detail::setCurrentRecord(nullptr, nullptr);
+
+  if (site != nullptr && accepted && Profiler::get().isRunning()) {
+    site->records.fetch_add(1, std::memory_order_relaxed);
+    site->bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
+
+/**\brief add time since the start to counter of the call site
+ */
+static void addTime(CallSite                             *site,
+                    std::chrono::steady_clock::time_point start) noexcept {
+  if (site != nullptr) {
+    site->nanoseconds.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count(),
+        std::memory_order_relaxed);
+  }
+}
+
+void SimpleLogger::write(const std::vector<AsyncRecord> &records) noexcept {
+  using Clock = std::chrono::steady_clock;
+
+  const SinkList &sinks = currentSinks();
+  if (Profiler::get().isRunning()) {
+    for (const AsyncRecord &record : records) {
+      detail::currentOrigin   = &record.origin;
+      Clock::time_point start = Clock::now();
+      write(record.site,
+            record.severity,
+            record.fileName,
+            record.lineNumber,
+            record.functionName,
+            record.message);
+      addTime(record.site, start);
+    }
+    detail::currentOrigin = nullptr;
+
+    for (const Sink &sink : sinks) {
+      sink.backend->flush();
+    }
+    return;
+  }
+
+  std::pmr::memory_resource *resource =
+      resource_.load(std::memory_order_relaxed);
+  RecordArena               *arena    = nullptr;
+  if (resource == nullptr) {
+    // all records of the batch are released at once after consuming
+    arena    = &RecordArena::local();
+    resource = arena->acquire();
+  }
+
+  // formatted records of every backend in order of logging
+  std::vector<std::pair<BasicBackend *, std::vector<RecordBuffer>>> outputs;
+  for (const AsyncRecord &record : records) {
+    detail::currentOrigin = &record.origin;
+    detail::setCurrentRecord(record.site, &record.message);
+
+    Channels channel =
+        record.site != nullptr ? record.site->channel : defaultChannel;
+    for (const Sink &sink : sinks) {
+      if (sink.frontend->isAccepted(record.severity, channel) == false ||
+          sink.frontend->isContentAccepted(record.site,
+                                           record.fileName,
+                                           record.functionName,
+                                           record.message) == false) {
+        continue;
+      }
+
+      auto output = std::find_if(outputs.begin(),
+                                 outputs.end(),
+                                 [&sink](const auto &item) {
+                                   return item.first == sink.backend.get();
+                                 });
+      if (output == outputs.end()) {
+        output = outputs.emplace(
+            outputs.end(), sink.backend.get(), std::vector<RecordBuffer>{});
+      }
+      RecordBuffer &buffer = output->second.emplace_back(resource);
+      sink.frontend->formatRecord(buffer,
+                                  record.severity,
+                                  record.fileName,
+                                  record.lineNumber,
+                                  record.functionName,
+                                  record.message);
+      if (buffer.empty()) {
+        output->second.pop_back();
+      }
+    }
+  }
+  detail::currentOrigin = nullptr;
+  detail::setCurrentRecord(nullptr, nullptr);
+
+  std::vector<std::string_view> views;
+  for (const auto &output : outputs) {
+    views.assign(output.second.begin(), output.second.end());
+    output.first->consumeBatch(views.data(), views.size());
+  }
+  outputs.clear();
+  if (arena != nullptr) {
+    arena->release();
+  }
+
+  for (const Sink &sink : sinks) {
+    sink.backend->flush();
+  }
+}
+
+void SimpleLogger::write(const std::vector<AsyncRecord> &records,
+                         FanOutPool                     &pool) noexcept {
+  using Clock        = std::chrono::steady_clock;
+  using SharedRecord = std::shared_ptr<const RecordBuffer>;
+  /// formatted record with its call site
+  using Item = std::pair<SharedRecord, CallSite *>;
+
+  std::pmr::memory_resource *resource =
+      resource_.load(std::memory_order_relaxed);
+  RecordArena               *arena    = nullptr;
+  if (resource == nullptr) {
+    // all records of the batch are released at once after consuming
+    arena    = &RecordArena::local();
+    resource = arena->acquire();
+  }
+
+  bool            profiling = Profiler::get().isRunning();
+  const SinkList &sinks     = currentSinks();
+  std::vector<std::pair<BasicBackend *, std::vector<Item>>>   outputs;
+  std::vector<std::pair<const BasicFrontend *, SharedRecord>> formatted;
+  for (const AsyncRecord &record : records) {
+    detail::currentOrigin = &record.origin;
+    detail::setCurrentRecord(record.site, &record.message);
+    formatted.clear();
+
+    Clock::time_point start;
+    if (profiling) {
+      start = Clock::now();
+    }
+
+    std::uint64_t bytes = 0;
+    Channels      channel =
+        record.site != nullptr ? record.site->channel : defaultChannel;
+    for (const Sink &sink : sinks) {
+      if (sink.frontend->isAccepted(record.severity, channel) == false ||
+          sink.frontend->isContentAccepted(record.site,
+                                           record.fileName,
+                                           record.functionName,
+                                           record.message) == false) {
+        continue;
+      }
+
+      auto found = std::find_if(formatted.begin(),
+                                formatted.end(),
+                                [&sink](const auto &item) {
+                                  return item.first == sink.frontend.get();
+                                });
+      if (found == formatted.end()) {
+        auto buffer = std::allocate_shared<RecordBuffer>(
+            std::pmr::polymorphic_allocator<RecordBuffer>{resource});
+        sink.frontend->formatRecord(*buffer,
+                                    record.severity,
+                                    record.fileName,
+                                    record.lineNumber,
+                                    record.functionName,
+                                    record.message);
+        found = formatted.emplace(
+            formatted.end(), sink.frontend.get(), std::move(buffer));
+      }
+      if (found->second->empty()) {
+        continue;
+      }
+
+      auto output = std::find_if(outputs.begin(),
+                                 outputs.end(),
+                                 [&sink](const auto &item) {
+                                   return item.first == sink.backend.get();
+                                 });
+      if (output == outputs.end()) {
+        output = outputs.emplace(
+            outputs.end(), sink.backend.get(), std::vector<Item>{});
+      }
+      output->second.emplace_back(found->second, record.site);
+      bytes += found->second->size();
+    }
+
+    if (profiling && record.site != nullptr) {
+      addTime(record.site, start);
+      if (bytes != 0) {
+        record.site->records.fetch_add(1, std::memory_order_relaxed);
+        record.site->bytes.fetch_add(bytes, std::memory_order_relaxed);
+      }
+    }
+  }
+  detail::currentOrigin = nullptr;
+  detail::setCurrentRecord(nullptr, nullptr);
+
+  std::vector<FanOutPool::Task> tasks;
+  for (const auto &output : outputs) {
+    tasks.emplace_back([&output, profiling]() {
+      for (const Item &item : output.second) {
+        Clock::time_point start;
+        if (profiling) {
+          start = Clock::now();
+        }
+
+        output.first->consume(*item.first);
+
+        if (profiling) {
+          addTime(item.second, start);
+        }
+      }
+      output.first->flush();
+    });
+  }
+  pool.run(tasks);
+
+  // shared records are allocated by the arena, so they are destroyed before
+  // releasing of it
+  outputs.clear();
+  formatted.clear();
+  if (arena != nullptr) {
+    arena->release();
+  }
+}
+
+void SimpleLogger::writePending(const SinkList &sinks, bool finish) noexcept {
+  for (const Sink &sink : sinks) {
+    RecordBuffer record;
+    sink.frontend->formatPending(record, finish);
+    if (record.empty() == false) {
+      sink.backend->consume(record);
+      sink.backend->flush();
+    }
+  }
+}
+
+std::uint64_t &SimpleLogger::lastQueuedSequence() noexcept {
+  thread_local std::uint64_t sequence = 0;
+  return sequence;
+}
+
+bool SimpleLogger::isAccepted(Severity severity, Channels channel) noexcept {
+  for (const Sink &sink : currentSinks()) {
+    if (sink.frontend->isAccepted(severity, channel)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SimpleLogger::checkSink(const Sink &sink) noexcept(false) {
+  if (sink.frontend == nullptr) {
+    throw std::invalid_argument{"invalid logger frontend"};
+  }
+  if (sink.backend == nullptr) {
+    throw std::invalid_argument{"invalid logger backend"};
+  }
+}
+
+const SimpleLogger::SinkList &SimpleLogger::currentSinks() noexcept {
+  thread_local std::shared_ptr<const SinkList> cache;
+  thread_local std::uint64_t                   cacheVersion = 0;
+
+  if (cacheVersion != version_.load(std::memory_order_acquire)) {
+    std::shared_ptr<const SinkList> previous;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      previous     = std::exchange(cache, sinks_);
+      cacheVersion = version_.load(std::memory_order_relaxed);
+    }
+    // previous sinks can be destroyed here, and destructor of backend can
+    // wait for writing, so it is done without lock of the logger
+  }
+  return *cache;
+}
+} // namespace logs
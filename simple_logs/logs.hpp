@@ -5,6 +5,11 @@
  * create std::shared_ptr from this and call LOGGER_ADD_SINK with frontend and
  * backend as parameters
  *
+ * The header is needed only for setting up of logger and for writing own
+ * frontends and backends. Files, which only write logs, should include
+ * lightweight `simple_logs/LogsFront.hpp` \see LogsFront.hpp. Implementation
+ * of logger is compiled in `simple_logs` library
+ *
  * You can set your own specific format for your message. For do it you
  * need define `DEFAULT_LOG_FORMAT` macro as c-string. The string can contains
  * 8 items defined by:
@@ -39,23 +44,28 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <boost/format.hpp>
 #include <chrono>
-#include <cstdlib>
-#include <iomanip>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <list>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
+#include <new>
+#include <optional>
+#include <simple_logs/LogsFront.hpp>
+#include <string>
 #include <string_view>
 #include <thread>
-
-#define TRACE_SEVERITY   "TRC"
-#define DEBUG_SEVERITY   "DBG"
-#define INFO_SEVERITY    "INF"
-#define WARNING_SEVERITY "WRN"
-#define THROW_SEVERITY   "THR"
-#define ERROR_SEVERITY   "ERR"
-#define FAILURE_SEVERITY "FLR"
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 // All args set in specific order for formatting
 #define SEVERITY      "%1%"
@@ -79,60 +89,16 @@
 #  define DEFAULT_LOG_FORMAT LIGHT_LOG_FORMAT
 #endif
 
-namespace logs {
-enum class Severity {
-  /// use in predicates
-  Placeholder,
-  Trace,
-  Debug,
-  Info,
-  Warning,
-  Throw,
-  Error,
-  Failure
-};
-
-inline std::string toString(Severity sev) {
-  switch (sev) {
-  case Severity::Trace:
-    return TRACE_SEVERITY;
-  case Severity::Debug:
-    return DEBUG_SEVERITY;
-  case Severity::Info:
-    return INFO_SEVERITY;
-  case Severity::Warning:
-    return WARNING_SEVERITY;
-  case Severity::Error:
-    return ERROR_SEVERITY;
-  case Severity::Failure:
-    return FAILURE_SEVERITY;
-  case Severity::Throw:
-    return THROW_SEVERITY;
-  default:
-    assert(false && "invalid severity");
-  }
-
-  return "";
-}
-} // namespace logs
-
 namespace std {
 /**\brief print time
  * \note this function is not thread safe
  */
-inline std::ostream &
+std::ostream &
 operator<<(std::ostream &stream,
            const std::chrono::time_point<std::chrono::system_clock>
-               &timePoint) noexcept {
-  std::time_t t = std::chrono::system_clock::to_time_t(timePoint);
-  stream << std::put_time(std::localtime(&t), "%c");
-  return stream;
-}
+               &timePoint) noexcept;
 
-inline std::ostream &operator<<(std::ostream &stream, logs::Severity sev) {
-  stream << logs::toString(sev);
-  return stream;
-}
+std::ostream &operator<<(std::ostream &stream, logs::Severity sev);
 } // namespace std
 
 namespace logs {
@@ -229,20 +195,29 @@ inline SeverityPredicat operator!(Severity val) {
   return makePredicate(Severity::Placeholder, val, std::not_equal_to<int>());
 }
 
-/**\return safety format object for user message
+/**\return argument as is, or its text representation if `formatter` is
+ * specialized for the type
  */
-inline boost::format getLogFormat(std::string_view format) noexcept {
-  boost::format retval{std::string{format}};
-  retval.exceptions(boost::io::all_error_bits ^ (boost::io::too_few_args_bit |
-                                                 boost::io::too_many_args_bit));
-  return retval;
+template <typename T>
+decltype(auto) formatArgument(const T &value) {
+  if constexpr (detail::HasFormat<T>::value) {
+    std::string retval;
+    formatter<T>::format(value, retval);
+    return retval;
+  } else {
+    return value;
+  }
 }
 
+/**\return safety format object for user message
+ */
+boost::format getLogFormat(std::string_view format) noexcept;
+
 /**\brief help function for combine all user arguments in one message
  */
 template <typename... Args>
-boost::format doFormat(boost::format format, Args... args) noexcept {
-  return (format % ... % args);
+boost::format doFormat(boost::format format, const Args &...args) noexcept {
+  return (format % ... % formatArgument(args));
 }
 
 /**\brief formatting user message
@@ -252,16 +227,131 @@ boost::format doFormat(boost::format format, Args... args) noexcept {
  */
 template <typename... Args>
 boost::format messageHandler(std::string_view messageFormat,
-                             Args... args) noexcept {
+                             const Args &...args) noexcept {
   boost::format format = getLogFormat(messageFormat);
   return doFormat(std::move(format), args...);
 }
 
+/**\brief time and thread of record
+ */
+struct RecordOrigin {
+  std::chrono::system_clock::time_point time;
+  std::thread::id                       threadId;
+};
+
+/**\return time of record, which is formatting now
+ * \note records can be formatted not in the thread, where they were logged, so
+ * frontends must use this function instead of `system_clock::now()`
+ */
+std::chrono::system_clock::time_point recordTime() noexcept;
+
+/**\return id of thread, which logged record
+ * \see recordTime
+ */
+std::thread::id recordThreadId() noexcept;
+
+/**\return call site of record, which is formatting now, or nullptr if the
+ * record was logged without call site
+ * \see recordTime
+ */
+CallSite *recordSite() noexcept;
+
+/**\return rendered message of record, which is formatting now. Message is
+ * rendered once for the record and shared by all its sinks, so frontends and
+ * filters should use it instead of `boost::format::str`
+ */
+std::string_view recordText(const boost::format &message) noexcept;
+
+/**\brief buffer for formatting records
+ * \see SimpleLogger::setMemoryResource
+ */
+using RecordBuffer = std::pmr::string;
+
+/**\brief append user message to the buffer without creating temporary string
+ */
+void appendMessage(RecordBuffer &output, const boost::format &message) noexcept;
+
+/**\brief append time in same format as `operator<<` for time point
+ * \note formatted time is cached for current second
+ */
+void appendTime(RecordBuffer                         &output,
+                std::chrono::system_clock::time_point timePoint) noexcept;
+
+/**\brief append thread id in same format as `operator<<` for thread id
+ * \note string representation of last thread id is cached
+ */
+void appendThreadId(RecordBuffer &output, std::thread::id id) noexcept;
+
+/**\brief compiled layout of record, which can contain same items as
+ * `DEFAULT_LOG_FORMAT`. Record is rendered directly to buffer without
+ * boost::format
+ *
+ * Text, file name, line number and function name never change for a call
+ * site, so if the record is written from a call site, then every run of these
+ * items is rendered once and cached in the call site
+ */
+class Layout {
+public:
+  /// items of layout in same order as in `DEFAULT_LOG_FORMAT`
+  enum Item {
+    Text,
+    SeverityItem,
+    FileNameItem,
+    LineNumberItem,
+    FunctionNameItem,
+    TimePointItem,
+    ThreadIdItem,
+    MessageItem
+  };
+
+  /**\throw exception if layout is invalid
+   */
+  explicit Layout(std::string_view layout) noexcept(false);
+
+  bool hasItem(Item item) const noexcept;
+
+  void render(RecordBuffer        &output,
+              Severity             severity,
+              std::string_view     fileName,
+              int                  lineNumber,
+              std::string_view     functionName,
+              const boost::format &message) const noexcept;
+
+private:
+  struct Segment {
+    Item        item;
+    std::string text;
+  };
+
+  /**\return true if the item is same for all records of a call site
+   */
+  static bool isSiteItem(Item item) noexcept;
+
+  void renderSegment(RecordBuffer        &output,
+                     const Segment       &segment,
+                     Severity             severity,
+                     std::string_view     fileName,
+                     int                  lineNumber,
+                     std::string_view     functionName,
+                     const boost::format &message) const noexcept;
+
+  /**\return cache of the layout in the call site, it is created at first call
+   */
+  const detail::LayoutCache &getCache(CallSite &site) const noexcept;
+
+private:
+  std::vector<Segment> segments_;
+  /// id of text of the layout, so layouts with same text share caches
+  std::uint64_t        id_;
+  /// true if the layout contains items of call site, which must be cached
+  bool                 hasSiteItems_;
+};
+
+class ContentFilter;
+
 class BasicFrontend {
 public:
-  BasicFrontend()
-      : filter_{Severity::Placeholder >= Severity::Trace} {
-  }
+  BasicFrontend();
   virtual ~BasicFrontend() = default;
 
   virtual std::string makeRecord(Severity         severity,
@@ -270,62 +360,154 @@ public:
                                  std::string_view functionName,
                                  boost::format    message) const noexcept = 0;
 
-  /**\throw exception if filter is invalid
+  /**\brief append record to the buffer. By default uses makeRecord, but
+   * frontends can override it for formatting directly to the buffer, which
+   * uses memory resource of logger
+   * \note if the buffer is left empty, then nothing is passed to backend
    */
-  void setFilter(SeverityPredicat filter) noexcept(false) {
-    if (filter == false) {
-      throw std::invalid_argument{"invalid severity filter"};
-    }
-
-    filter_ = std::move(filter);
+  virtual void formatRecord(RecordBuffer        &buffer,
+                            Severity             severity,
+                            std::string_view     fileName,
+                            int                  lineNumber,
+                            std::string_view     functionName,
+                            const boost::format &message) const noexcept;
+
+  /**\brief append records, which are kept by the frontend, to the buffer.
+   * Called by `SimpleLogger::flush`, for removed sinks in
+   * `SimpleLogger::setSinks` and at destruction of logger. By default
+   * frontend keeps nothing
+   * \param finish if true, then all kept records must be appended, because
+   * the frontend isn't used anymore
+   */
+  virtual void formatPending(RecordBuffer &, bool) const noexcept {
   }
 
+  /**\throw exception if filter is invalid
+   */
+  void setFilter(SeverityPredicat filter) noexcept(false);
+
   SeverityPredicat getFilter() const noexcept {
     return filter_;
   }
 
+  /**\brief set channels, records of which are accepted by the frontend, all
+   * channels by default
+   * \see getChannel
+   */
+  void setChannels(Channels channels) noexcept;
+
+  Channels getChannels() const noexcept {
+    return channels_;
+  }
+
+  /**\brief set filter of records by source and message, in addition to
+   * filter of severities. nullptr (by default) accepts all records
+   * \see ContentFilter
+   */
+  void setContentFilter(std::shared_ptr<const ContentFilter> filter) noexcept {
+    contentFilter_ = std::move(filter);
+  }
+
+  const std::shared_ptr<const ContentFilter> &getContentFilter()
+      const noexcept {
+    return contentFilter_;
+  }
+
+  /**\return true if the frontend accepts record with the severity from the
+   * channel. The filter is evaluated for every severity in `setFilter`, so
+   * the check is only two bit tests
+   */
+  bool isAccepted(Severity severity, Channels channel) const noexcept {
+    return (severities_ & (1u << static_cast<int>(severity))) != 0 &&
+           (channels_ & channel) != 0;
+  }
+
+  /**\return true if content filter accepts the record, which is accepted by
+   * `isAccepted`
+   * \param site can be nullptr
+   */
+  bool isContentAccepted(CallSite            *site,
+                         std::string_view     fileName,
+                         std::string_view     functionName,
+                         const boost::format &message) const noexcept {
+    return contentFilter_ == nullptr ||
+           acceptContent(site, fileName, functionName, message);
+  }
+
 private:
-  SeverityPredicat filter_;
+  bool acceptContent(CallSite            *site,
+                     std::string_view     fileName,
+                     std::string_view     functionName,
+                     const boost::format &message) const noexcept;
+
+private:
+  SeverityPredicat                     filter_;
+  /// bits of severities, which are accepted by filter
+  std::uint32_t                        severities_;
+  Channels                             channels_;
+  std::shared_ptr<const ContentFilter> contentFilter_;
 };
 
-class StandardFrontend final : public BasicFrontend {
+/**\brief base for frontends, which use Layout
+ */
+class LayoutFrontend : public BasicFrontend {
 public:
   std::string makeRecord(Severity         severity,
                          std::string_view fileName,
                          int              lineNumber,
                          std::string_view functionName,
-                         boost::format    message) const noexcept override {
-    boost::format standardLogFormat{STANDARD_LOG_FORMAT};
-    standardLogFormat.exceptions(boost::io::all_error_bits ^
-                                 boost::io::too_many_args_bit);
+                         boost::format    message) const noexcept override;
 
-    standardLogFormat % severity % fileName % lineNumber % functionName %
-        std::chrono::system_clock::now() % std::this_thread::get_id() % message;
+  void formatRecord(RecordBuffer        &buffer,
+                    Severity             severity,
+                    std::string_view     fileName,
+                    int                  lineNumber,
+                    std::string_view     functionName,
+                    const boost::format &message) const noexcept override;
 
-    return standardLogFormat.str();
-  }
+  virtual const Layout &getLayout() const noexcept = 0;
+};
+
+class StandardFrontend final : public LayoutFrontend {
+public:
+  const Layout &getLayout() const noexcept override;
 };
 
 /**\brief like a StandardFrontend, but don't use time
  */
-class LightFrontend final : public BasicFrontend {
+class LightFrontend final : public LayoutFrontend {
 public:
-  std::string makeRecord(Severity         severity,
-                         std::string_view fileName,
-                         int              lineNumber,
-                         std::string_view functionName,
-                         boost::format    message) const noexcept override {
-    boost::format standardLogFormat{LIGHT_LOG_FORMAT};
-    standardLogFormat.exceptions(boost::io::all_error_bits ^
-                                 boost::io::too_many_args_bit);
+  const Layout &getLayout() const noexcept override;
+};
 
-    standardLogFormat % severity % fileName % lineNumber % functionName % "" %
-        "" % message;
+/**\brief frontend with layout, which is set at runtime. The layout can
+ * contain same items as `DEFAULT_LOG_FORMAT`
+ */
+class CustomFrontend final : public LayoutFrontend {
+public:
+  /**\throw exception if layout is invalid
+   */
+  explicit CustomFrontend(std::string_view layout) noexcept(false)
+      : layout_{layout} {
+  }
 
-    return standardLogFormat.str();
+  const Layout &getLayout() const noexcept override {
+    return layout_;
   }
+
+private:
+  Layout layout_;
 };
 
+/**\brief construct the object again in child process after fork. Use it for
+ * condition variables and threads, which are copied from parent in state of
+ * threads, which don't exist in child. Previous object is not destroyed
+ */
+template <typename T>
+void reinitializeAfterFork(T &object) noexcept {
+  new (&object) T{};
+}
+
 class BasicBackend {
 public:
   virtual ~BasicBackend() = default;
@@ -335,6 +517,37 @@ public:
    * data race by using mutex
    */
   virtual void consume(std::string_view record) noexcept = 0;
+
+  /**\brief get several records at once, by default they are consumed one by
+   * one. Backends, which lock or write every record, should override it
+   * \note `flush` is called after the batch
+   */
+  virtual void consumeBatch(const std::string_view *records,
+                            std::size_t             count) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+      consume(records[i]);
+    }
+  }
+
+  /**\brief write all buffered records
+   * \note asynchronous writer calls it after every batch of records
+   */
+  virtual void flush() noexcept {
+  }
+
+  /**\brief called before `fork()`, backend must finish writing of current
+   * record and lock itself, so child process gets it in consistent state
+   * \note backends, which use mutexes or own threads, must override it
+   */
+  virtual void lockForFork() noexcept {
+  }
+
+  /**\brief called after `fork()` in parent and child processes. Child must
+   * reinitialize threads and condition variables of the backend
+   * \param child true in child process
+   */
+  virtual void unlockAfterFork([[maybe_unused]] bool child) noexcept {
+  }
 };
 
 class TextStreamBackend final : public BasicBackend {
@@ -345,14 +558,83 @@ public:
 
   /**\note uses mutex
    */
-  void consume(std::string_view record) noexcept override {
+  void consume(std::string_view record) noexcept override;
+
+  /**\note locks mutex once for all records
+   */
+  void consumeBatch(const std::string_view *records,
+                    std::size_t             count) noexcept override;
+
+  void flush() noexcept override;
+
+  void lockForFork() noexcept override;
+
+  void unlockAfterFork(bool child) noexcept override;
+
+private:
+  std::ostream &stream_;
+  std::mutex    mutex_;
+};
+
+/**\brief write records to file and rotate it, if maximal size is set
+ *
+ * At rotation `file` is renamed to `file.1`, `file.1` to `file.2` and etc.
+ * Only `maxFiles` previous files are kept
+ */
+class FileBackend final : public BasicBackend {
+public:
+  /**\param maxSize maximal size of file in bytes, 0 means without rotation
+   * \throw exception if file can not be opened
+   */
+  explicit FileBackend(std::string fileName,
+                       std::size_t maxSize  = 0,
+                       std::size_t maxFiles = 1) noexcept(false);
+
+  /**\note uses mutex
+   */
+  void consume(std::string_view record) noexcept override;
+
+  /**\note locks mutex once for all records
+   */
+  void consumeBatch(const std::string_view *records,
+                    std::size_t             count) noexcept override;
+
+  void flush() noexcept override;
+
+  void lockForFork() noexcept override;
+
+  /**\note if separate child files are set, then child process reopens the
+   * file with new name
+   */
+  void unlockAfterFork(bool child) noexcept override;
+
+  const std::string &getFileName() const noexcept {
+    return fileName_;
+  }
+
+  /**\brief if true, then after `fork()` child process writes to own file
+   * `fileName.pid`, so records of prefork workers are not mixed
+   */
+  void setSeparateChildFiles(bool separate) noexcept {
     std::lock_guard<std::mutex> lock{mutex_};
-    stream_ << record << std::endl;
+    separateChildFiles_ = separate;
   }
 
 private:
-  std::ostream &stream_;
+  void open() noexcept;
+
+  void rotate() noexcept;
+
+private:
+  /// name of file of the process, which created the backend
+  std::string   baseName_;
+  std::string   fileName_;
+  std::size_t   maxSize_;
+  std::size_t   maxFiles_;
+  std::size_t   size_;
+  std::ofstream stream_;
   std::mutex    mutex_;
+  bool          separateChildFiles_;
 };
 
 struct Sink {
@@ -360,118 +642,452 @@ struct Sink {
   std::shared_ptr<BasicBackend>  backend;
 };
 
+/**\brief per-thread monotonic arena for formatting records. All memory of
+ * the arena is released, when formatted record is handed off to backend
+ */
+class RecordArena {
+public:
+  static RecordArena &local() noexcept;
+
+  std::pmr::memory_resource *acquire() noexcept {
+    ++users_;
+    return &resource_;
+  }
+
+  /**\brief release all memory of the arena, if nobody uses it
+   */
+  void release() noexcept {
+    if (--users_ == 0) {
+      resource_.release();
+    }
+  }
+
+private:
+  RecordArena() noexcept
+      : resource_{buffer_, sizeof(buffer_)}
+      , users_{0} {
+  }
+
+  RecordArena(const RecordArena &) = delete;
+  RecordArena(RecordArena &&)      = delete;
+
+private:
+  alignas(std::max_align_t) char      buffer_[4096];
+  std::pmr::monotonic_buffer_resource resource_;
+  /// records can be logged recursively (from backend), so arena can be
+  /// released only after handing off all of them
+  int users_;
+};
+
+/**\brief settings of asynchronous logging
+ * \see SimpleLogger::setAsync
+ */
+struct AsyncSettings {
+  /// records with the severity or higher are written and flushed immediately,
+  /// other records are written by batches
+  Severity urgentSeverity = Severity::Warning;
+
+  /// maximal count of records in batch
+  std::size_t batchSize = 256;
+
+  /// maximal time of waiting for filling batch
+  std::chrono::milliseconds batchDelay{100};
+
+  /// if true, then records are written in order of logging. Otherwise urgent
+  /// records are written before records, which was logged earlier
+  bool keepOrder = false;
+
+  /// records, which satisfy the predicate, are written in the thread, which
+  /// logs them, and backends are flushed before returning. Records of the
+  /// thread, which were queued before, are written first. By default all
+  /// records are asynchronous
+  SeverityPredicat synchronous{nullptr};
+
+  /// count of threads for writing to several backends in parallel, 0 means
+  /// that all backends are written by writer thread one after another
+  std::size_t fanOutThreads = 0;
+};
+
+/**\brief record, which waits for writing in asynchronous mode
+ * \warning file name and function name must be valid until end of program,
+ * so use only string literals (as logging macroses do)
+ */
+struct AsyncRecord {
+  /// set by AsyncQueue in order of logging
+  std::uint64_t    sequence;
+  Severity         severity;
+  std::string_view fileName;
+  int              lineNumber;
+  std::string_view functionName;
+  RecordOrigin     origin;
+  /// nullptr if record is logged without call site
+  CallSite        *site;
+  boost::format    message;
+};
+
+/**\brief small pool of threads for running several tasks in parallel
+ */
+class FanOutPool {
+public:
+  using Task = std::function<void()>;
+
+  explicit FanOutPool(std::size_t threads) noexcept(false);
+  ~FanOutPool();
+
+  std::size_t getThreadCount() const noexcept {
+    return threads_.size();
+  }
+
+  /**\brief run all tasks and wait until they finish. Current thread also runs
+   * the tasks
+   */
+  void run(std::vector<Task> &tasks) noexcept;
+
+private:
+  FanOutPool(const FanOutPool &) = delete;
+  FanOutPool(FanOutPool &&)      = delete;
+
+  /**\note must be called under mutex
+   */
+  void runTasks(std::unique_lock<std::mutex> &lock) noexcept;
+
+  void work() noexcept;
+
+private:
+  std::mutex               mutex_;
+  std::condition_variable  cv_;
+  std::condition_variable  doneCv_;
+  std::vector<Task>       *tasks_;
+  std::size_t              next_;
+  std::size_t              remaining_;
+  std::uint64_t            generation_;
+  bool                     stopped_;
+  std::vector<std::thread> threads_;
+};
+
+/**\brief queue of records with background writer thread
+ *
+ * Every severity has own lane. Urgent lanes are drained first, and backends
+ * are flushed immediately after them. Other lanes are drained, when batch is
+ * full or after delay
+ */
+class AsyncQueue {
+public:
+  /// write records to backends and flush them, pool can be nullptr
+  using Writer = std::function<void(const std::vector<AsyncRecord> &records,
+                                    FanOutPool                     *pool)>;
+
+  AsyncQueue() noexcept;
+  ~AsyncQueue();
+
+  /**\brief start writer thread or change settings of running writer
+   */
+  void start(AsyncSettings settings, Writer writer) noexcept(false);
+
+  /**\brief write all queued records and stop writer thread
+   */
+  void stop() noexcept;
+
+  /**\brief wait until all records, which were queued before the call, are
+   * written
+   * \param sequence if set, then wait only for records up to the sequence
+   * number
+   */
+  void flush(std::uint64_t sequence = UINT64_MAX) noexcept;
+
+  bool isRunning() const noexcept {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  /**\return true if current thread is writer thread or thread of its fan-out
+   * pool, so waiting for written records in it never finishes
+   */
+  static bool isWriterThread() noexcept;
+
+  /**\return sequence number of the record, or 0 if writer is not running, so
+   * the record must be written synchronously
+   */
+  std::uint64_t push(AsyncRecord &&record) noexcept;
+
+  /**\brief push all records by one lock, records are moved from the vector
+   * \return sequence number of last record, or 0 if writer is not running
+   */
+  std::uint64_t push(std::vector<AsyncRecord> &records) noexcept;
+
+  /**\brief lock the queue before `fork()`, writer thread finishes current
+   * batch and waits
+   */
+  void lockForFork() noexcept;
+
+  /**\brief unlock the queue after `fork()`. In child process queued records
+   * of parent are dropped, and writer thread is started again
+   */
+  void unlockAfterFork(bool child) noexcept;
+
+private:
+  bool isUrgent(Severity severity) const noexcept {
+    return static_cast<int>(severity) >=
+           static_cast<int>(settings_.urgentSeverity);
+  }
+
+  /**\note must be called under mutex
+   */
+  bool isBatchReady() const noexcept;
+
+  /**\brief add record to its lane
+   * \return true if writer thread must be woken up
+   * \note must be called under mutex
+   */
+  bool enqueue(AsyncRecord &&record) noexcept;
+
+  void run() noexcept;
+
+private:
+  std::mutex                              mutex_;
+  std::condition_variable                 cv_;
+  std::condition_variable                 writtenCv_;
+  std::thread                             thread_;
+  std::atomic_bool                        running_;
+  AsyncSettings                           settings_;
+  Writer                                  writer_;
+  std::array<std::vector<AsyncRecord>, 8> lanes_;
+  std::uint64_t                           sequence_;
+  std::uint64_t                           written_;
+  std::size_t                             urgentCount_;
+  std::size_t                             regularCount_;
+  std::chrono::steady_clock::time_point   batchStart_;
+  bool                                    flushRequested_;
+};
+
 class SimpleLogger {
 public:
+  using SinkList = std::list<Sink>;
+
   void log(Severity         severity,
            std::string_view fileName,
            int              lineNumber,
            std::string_view functionName,
-           boost::format    message) noexcept {
-    // XXX in case of using several threads here can be a data race, because
-    // sink creates in main thread, but this function can be called from other
-    // thread. But it is ok, becuase we don't change sink, frontend or backend
-    // in this function
-    for (Sink &sink : sinks_) {
-      if (sink.frontend->getFilter()(severity)) {
-        std::string record = sink.frontend->makeRecord(severity,
-                                                       fileName,
-                                                       lineNumber,
-                                                       functionName,
-                                                       message);
-        sink.backend->consume(record);
-      }
-    }
+           boost::format    message) noexcept;
+
+  /**\brief log record of the call site, cost of the record is counted by
+   * Profiler
+   */
+  void log(CallSite &site, Severity severity, boost::format message) noexcept;
+
+  /**\brief log record, which was logged before, with its original time and
+   * thread. It is used for records, which were kept in RequestBuffer
+   */
+  void log(CallSite           &site,
+           Severity            severity,
+           boost::format       message,
+           const RecordOrigin &origin) noexcept;
+
+  /**\brief log several records at once, \see Batch. Every backend gets all
+   * its records by one call. Records are moved from the vector
+   */
+  void log(std::vector<AsyncRecord> &records) noexcept;
+
+  /**\brief format and write records in background thread. If asynchronous
+   * mode is already enabled, then only settings are changed
+   * \warning file names and function names must be valid until end of
+   * program, \see AsyncRecord
+   * \note the mode is kept in child process after `fork()`, writer thread is
+   * started again there
+   */
+  void setAsync(AsyncSettings settings) noexcept(false);
+
+  /**\brief write all queued records and return to synchronous mode
+   */
+  void setSync() noexcept {
+    queue_.stop();
   }
 
-  /**\throw exception if frontend or backend are invalid
+  bool isAsync() const noexcept {
+    return queue_.isRunning();
+  }
+
+  /**\return true if records with the severity are written in asynchronous
+   * mode by the thread, which logs them, \see AsyncSettings::synchronous.
+   * Such records must not be delayed by buffers of the thread
    */
-  void addSink(Sink sink) noexcept(false) {
-    if (sink.frontend == nullptr) {
-      throw std::invalid_argument{"invalid logger frontend"};
-    }
-    if (sink.backend == nullptr) {
-      throw std::invalid_argument{"invalid logger backend"};
-    }
+  bool isSynchronous(Severity severity) const noexcept {
+    return queue_.isRunning() && (synchronous_.load(std::memory_order_relaxed) &
+                                  (1u << static_cast<int>(severity))) != 0;
+  }
 
-    sinks_.emplace_back(std::move(sink));
+  /**\brief set memory resource for formatting records
+   * \param resource must be thread safe and valid until end of program. If
+   * nullptr, then every thread uses own RecordArena (by default)
+   */
+  void setMemoryResource(std::pmr::memory_resource *resource) noexcept {
+    resource_.store(resource, std::memory_order_relaxed);
   }
 
-  static SimpleLogger &get() noexcept {
-    static SimpleLogger logger;
-    return logger;
+  /**\brief wait until all records, which were logged before, are written,
+   * then write pending records of frontends
+   * \see BasicFrontend::formatPending
+   */
+  void flush() noexcept;
+
+  /**\return false if no sink accepts records with the severity from the
+   * channel. It is only one atomic load, so it is checked before formatting
+   * of message
+   */
+  bool mayAccept(Severity severity, Channels channel) const noexcept {
+    return (accepted_[static_cast<int>(severity)].load(
+                std::memory_order_relaxed) &
+            channel) != 0;
   }
 
+  /**\brief update channels, which are accepted by sinks for every severity,
+   * if the frontend is used by some sink. Called by frontends after changing
+   * of their filters, so setting up of new frontend doesn't change logger
+   */
+  void updateAccepted(const BasicFrontend &frontend) noexcept;
+
+  /**\throw exception if frontend or backend are invalid
+   */
+  void addSink(Sink sink) noexcept(false);
+
+  /**\brief replace all sinks of the logger at once. Records, which are logging
+   * at the moment, are still consumed by previous sinks
+   * \throw exception if some frontend or backend are invalid. In this case
+   * sinks are not changed
+   */
+  void setSinks(SinkList sinks) noexcept(false);
+
+  /**\brief replace all sinks and mode of the logger at once. Sinks and
+   * severities, which are written synchronously, are published by one swap
+   * under mutex of logger, \see setSinks and setAsync
+   * \param async settings of asynchronous mode, nothing means synchronous
+   * mode. Records, which are queued at the moment, are written by new sinks
+   * \throw exception if some frontend or backend are invalid or writer thread
+   * can not be started. In this case logger is not changed
+   */
+  void configure(SinkList sinks, std::optional<AsyncSettings> async) noexcept(
+      false);
+
+  static SimpleLogger &get() noexcept;
+
 private:
-  SimpleLogger() noexcept {
-  }
+  /**\brief handlers of `pthread_atfork`. Queued records are written before
+   * fork, then logger, queue and all backends are locked, so child gets them
+   * in consistent state
+   */
+  static void prepareFork() noexcept;
+  static void parentAfterFork() noexcept;
+  static void childAfterFork() noexcept;
+
+  SimpleLogger() noexcept;
 
   SimpleLogger(const SimpleLogger &) = delete;
   SimpleLogger(SimpleLogger &&)      = delete;
 
+  ~SimpleLogger();
+
+  /**\param site can be nullptr
+   * \param origin if nullptr, then record is logged now by current thread
+   */
+  void doLog(CallSite           *site,
+             Severity            severity,
+             std::string_view    fileName,
+             int                 lineNumber,
+             std::string_view    functionName,
+             boost::format       message,
+             const RecordOrigin *origin) noexcept;
+
+  /**\param site if set, then count of written records and their size are
+   * added to its counters
+   * \param flush if true, then backends are flushed after writing
+   */
+  void write(CallSite            *site,
+             Severity             severity,
+             std::string_view     fileName,
+             int                  lineNumber,
+             std::string_view     functionName,
+             const boost::format &message,
+             bool                 flush = false) noexcept;
+
+  /**\brief write records and flush backends. Every backend gets all its
+   * records by one call, but while Profiler is running records are written one
+   * by one, so their time is measured
+   */
+  void write(const std::vector<AsyncRecord> &records) noexcept;
+
+  /**\brief format records and write them to all backends in parallel. Every
+   * record is formatted only once for every frontend, and formatted record is
+   * shared between backends
+   */
+  void write(const std::vector<AsyncRecord> &records,
+             FanOutPool                     &pool) noexcept;
+
+  /**\brief write pending records of frontends of the sinks and flush
+   * backends \see BasicFrontend::formatPending
+   */
+  void writePending(const SinkList &sinks, bool finish) noexcept;
+
+  /**\return sequence number of last record, which was queued by current
+   * thread and maybe is not written yet
+   */
+  static std::uint64_t &lastQueuedSequence() noexcept;
+
+  /**\return true if some sink accepts records with the severity from the
+   * channel
+   */
+  bool isAccepted(Severity severity, Channels channel) noexcept;
+
+  static void checkSink(const Sink &sink) noexcept(false);
+
+  /**\brief start writer thread or change settings of running writer
+   */
+  void startQueue(const AsyncSettings &settings) noexcept(false);
+
+  /**\brief replace sinks, and mask of synchronous severities if it is set,
+   * under mutex, then write pending records of removed frontends
+   */
+  void replaceSinks(std::shared_ptr<const SinkList> current,
+                    std::optional<std::uint32_t>    synchronous) noexcept;
+
+  /**\brief update accepted channels by the sinks, mutex must be locked
+   */
+  void updateAccepted(const SinkList &sinks) noexcept;
+
+  /**\return sinks of the logger, cached for current thread. Cache is updated
+   * only after changing of sinks, so usually here is only one atomic load
+   * \note previous sinks are destroyed only when all threads, which used them,
+   * update their caches (or finish)
+   */
+  const SinkList &currentSinks() noexcept;
+
 private:
-  std::list<Sink> sinks_;
+  std::mutex                               mutex_;
+  std::shared_ptr<const SinkList>          sinks_;
+  std::atomic_uint64_t                     version_;
+  AsyncQueue                               queue_;
+  /// mask of severities, which are written synchronously in asynchronous mode
+  std::atomic_uint32_t                     synchronous_;
+  /// if nullptr, then RecordArena is used
+  std::atomic<std::pmr::memory_resource *> resource_;
+  /// channels, which are accepted by some sink, for every severity
+  std::array<std::atomic<Channels>, static_cast<int>(Severity::Failure) + 1>
+                                           accepted_;
+  /// sinks and their unique backends, which are locked for fork
+  std::shared_ptr<const SinkList>          forkSinks_;
+  std::vector<BasicBackend *>              forkBackends_;
 };
 } // namespace logs
 
 #define LOGGER logs::SimpleLogger::get()
 
 /**\brief add new sink for logger
- * \warning use it before calling any log macroses! And do not add additional
- * sinks after calling some logging macroses. This can have unexpected behaviour
+ * \note sinks can be added at any time, also when other threads are logging
  */
 #define LOGGER_ADD_SINK(frontend, backend)                                     \
   LOGGER.addSink(logs::Sink{frontend, backend})
 
 #ifndef LOG_FORMAT
-#  define LOG_FORMAT(severity, message)                                        \
-    LOGGER.log(severity, __FILE__, __LINE__, __func__, message);
-#endif
-
-#ifndef LOG_TRACE
-#  define LOG_TRACE(...)                                                       \
-    LOG_FORMAT(logs::Severity::Trace, logs::messageHandler(__VA_ARGS__))
-#endif
-
-#ifndef LOG_DEBUG
-#  define LOG_DEBUG(...)                                                       \
-    LOG_FORMAT(logs::Severity::Debug, logs::messageHandler(__VA_ARGS__))
-#endif
-
-#ifndef LOG_INFO
-#  define LOG_INFO(...)                                                        \
-    LOG_FORMAT(logs::Severity::Info, logs::messageHandler(__VA_ARGS__))
-#endif
-
-#ifndef LOG_WARNING
-#  define LOG_WARNING(...)                                                     \
-    LOG_FORMAT(logs::Severity::Warning, logs::messageHandler(__VA_ARGS__))
-#endif
-
-#ifndef LOG_ERROR
-#  define LOG_ERROR(...)                                                       \
-    LOG_FORMAT(logs::Severity::Error, logs::messageHandler(__VA_ARGS__))
-#endif
-
-#ifndef LOG_FAILURE
-/**\brief print log and terminate program
- * \warning be careful with redefining! `LOG_FAILURE` must finish program,
- * otherwise it can has unexpected behaviour
+/**\brief log already formatted message \see messageHandler
  */
-#  define LOG_FAILURE(...)                                                     \
-    LOG_FORMAT(logs::Severity::Failure, logs::messageHandler(__VA_ARGS__));    \
-    exit(EXIT_FAILURE)
-#endif
-
-#ifndef LOG_THROW
-/**\brief print log and generate specified exception
- * \param ExceptionType type of generated exception
- * \warning be careful with redefining! `LOG_THROW` must throw needed exception,
- * otherwise it can has unexpected behaviour
- */
-#  define LOG_THROW(ExceptionType, ...)                                        \
-    {                                                                          \
-      boost::format fmt = logs::messageHandler(__VA_ARGS__);                   \
-      LOG_FORMAT(logs::Severity::Throw, fmt);                                  \
-      throw ExceptionType{fmt.str()};                                          \
-    }
+#  define LOG_FORMAT(severity, message)                                        \
+    LOGGER.log(severity, LOGS_FILE_NAME, __LINE__, LOGS_FUNCTION_NAME, message);
 #endif
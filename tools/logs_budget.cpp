@@ -0,0 +1,286 @@
+// logs_budget.cpp
+/**\file
+ * Checks that performance properties of logger are kept. For every
+ * combination of frontend, backend and mode of logger it logs records and
+ * counts heap allocations and I/O syscalls of the thread, which logs, then
+ * compares them with budget. Program fails if some budget is exceeded, so
+ * regressions can be caught by CI.
+ *
+ * ```
+ * logs_budget [--verbose]
+ * ```
+ *
+ * Allocations are counted by interposing `malloc` family of glibc, so they
+ * are not counted with sanitizers or other libc. Syscalls are counted by
+ * interposing libc wrappers `write`, `writev`, `pwrite`, `send`, `sendto`,
+ * `fsync` and `fdatasync`, which are used by backends for writing records.
+ * Counters are per thread, so work of asynchronous writer is not counted
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <simple_logs/logs.hpp>
+#include <streambuf>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) &&                    \
+    !defined(__SANITIZE_THREAD__)
+#  define LOGS_BUDGET_COUNT_ALLOCATIONS 1
+#else
+#  define LOGS_BUDGET_COUNT_ALLOCATIONS 0
+#endif
+
+namespace {
+/**\brief counters of current thread, they are changed only if `enabled`
+ */
+struct Counters {
+  bool          enabled;
+  std::uint64_t allocations;
+  std::uint64_t bytes;
+  std::uint64_t syscalls;
+};
+
+thread_local Counters counters{false, 0, 0, 0};
+
+inline void countAllocation(std::size_t size) noexcept {
+  if (counters.enabled) {
+    ++counters.allocations;
+    counters.bytes += size;
+  }
+}
+
+inline void countSyscall() noexcept {
+  if (counters.enabled) {
+    ++counters.syscalls;
+  }
+}
+} // namespace
+
+extern "C" {
+#if LOGS_BUDGET_COUNT_ALLOCATIONS
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+
+void *malloc(std::size_t size) {
+  countAllocation(size);
+  return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) {
+  countAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, std::size_t size) {
+  countAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size) {
+  countAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, std::size_t alignment, std::size_t size) {
+  countAllocation(size);
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr != nullptr ? 0 : ENOMEM;
+}
+#endif
+
+ssize_t write(int fd, const void *buffer, std::size_t size) {
+  countSyscall();
+  return syscall(SYS_write, fd, buffer, size);
+}
+
+ssize_t writev(int fd, const struct iovec *iov, int count) {
+  countSyscall();
+  return syscall(SYS_writev, fd, iov, count);
+}
+
+ssize_t pwrite(int fd, const void *buffer, std::size_t size, off_t offset) {
+  countSyscall();
+  return syscall(SYS_pwrite64, fd, buffer, size, offset);
+}
+
+ssize_t send(int fd, const void *buffer, std::size_t size, int flags) {
+  countSyscall();
+  return syscall(SYS_sendto, fd, buffer, size, flags, nullptr, 0);
+}
+
+ssize_t sendto(int                    fd,
+               const void            *buffer,
+               std::size_t            size,
+               int                    flags,
+               const struct sockaddr *address,
+               socklen_t              addressSize) {
+  countSyscall();
+  return syscall(SYS_sendto, fd, buffer, size, flags, address, addressSize);
+}
+
+int fsync(int fd) {
+  countSyscall();
+  return syscall(SYS_fsync, fd);
+}
+
+int fdatasync(int fd) {
+  countSyscall();
+  return syscall(SYS_fdatasync, fd);
+}
+}
+
+namespace {
+/// records, which are logged before counting, so lazy initialization of
+/// caches and thread locals is not counted
+constexpr int warmUpRecords  = 1000;
+constexpr int countedRecords = 10000;
+
+/// file of `file` backend
+constexpr const char *budgetFile = "logs_budget.log";
+
+/**\brief drops everything, so growing of stream is not counted
+ */
+class NullStreamBuffer final : public std::streambuf {
+protected:
+  int_type overflow(int_type c) override {
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *, std::streamsize count) override {
+    return count;
+  }
+};
+
+/**\brief maximal average count of allocations and syscalls per record
+ */
+struct Budget {
+  const char *frontend;
+  const char *backend;
+  bool        async;
+  /// if false, then records are filtered out by severity
+  bool        enabled;
+  double      allocations;
+  double      syscalls;
+};
+
+std::shared_ptr<logs::BasicFrontend> makeFrontend(std::string_view name) {
+  if (name == "standard") {
+    return std::make_shared<logs::StandardFrontend>();
+  } else if (name == "light") {
+    return std::make_shared<logs::LightFrontend>();
+  }
+  return std::make_shared<logs::CustomFrontend>(
+      SEVERITY " " THREAD_ID " " FILE_NAME ":" LINE_NUMBER " " MESSAGE_PREFIX
+               " " MESSAGE);
+}
+
+std::shared_ptr<logs::BasicBackend> makeBackend(std::string_view name,
+                                                std::ostream    &stream) {
+  if (name == "stream") {
+    return std::make_shared<logs::TextStreamBackend>(stream);
+  }
+  return std::make_shared<logs::FileBackend>(budgetFile);
+}
+
+void logRecords(int count, bool enabled) {
+  for (int i = 0; i < count; ++i) {
+    if (enabled) {
+      LOG_INFO("request %1% from %2% took %3% ms", i, "user", 3.5);
+    } else {
+      LOG_DEBUG("request %1% from %2% took %3% ms", i, "user", 3.5);
+    }
+  }
+}
+
+/**\return true if the budget is kept
+ */
+bool check(const Budget &budget, bool verbose) {
+  NullStreamBuffer                     buffer;
+  std::ostream                         stream{&buffer};
+  std::shared_ptr<logs::BasicFrontend> frontend =
+      makeFrontend(budget.frontend);
+  frontend->setFilter(logs::Severity::Placeholder >= logs::Severity::Info);
+  LOGGER.setSinks({logs::Sink{frontend, makeBackend(budget.backend, stream)}});
+  if (budget.async) {
+    LOGGER.setAsync(logs::AsyncSettings{});
+  }
+
+  logRecords(warmUpRecords, budget.enabled);
+  LOGGER.flush();
+
+  counters = Counters{true, 0, 0, 0};
+  logRecords(countedRecords, budget.enabled);
+  counters.enabled = false;
+
+  LOGGER.setSync();
+  LOGGER.setSinks({});
+
+  double allocations = double(counters.allocations) / countedRecords;
+  double bytes       = double(counters.bytes) / countedRecords;
+  double syscalls    = double(counters.syscalls) / countedRecords;
+
+  bool kept = syscalls <= budget.syscalls;
+  if (LOGS_BUDGET_COUNT_ALLOCATIONS) {
+    kept = kept && allocations <= budget.allocations;
+  }
+  if (verbose || kept == false) {
+    std::cout << std::left << std::setw(10) << budget.frontend << std::setw(8)
+              << budget.backend << std::setw(7)
+              << (budget.async ? "async" : "sync") << std::setw(10)
+              << (budget.enabled ? "enabled" : "disabled") << std::right
+              << std::fixed << std::setprecision(2)
+              << " allocations " << std::setw(6) << allocations << " / "
+              << std::setw(6) << budget.allocations << "  bytes "
+              << std::setw(8) << bytes << "  syscalls " << std::setw(4)
+              << syscalls << " / " << std::setw(4) << budget.syscalls
+              << (kept ? "" : "  EXCEEDED") << std::endl;
+  }
+  return kept;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool verbose = argc > 1 && std::string_view{argv[1]} == "--verbose";
+
+  // disabled records are dropped before formatting of message, so they cost
+  // nothing. File backend flushes every record in synchronous mode, so it
+  // makes one syscall per record
+  // clang-format off
+  const Budget budgets[] = {
+      // frontend  backend   async  enabled allocations syscalls
+      {"standard", "stream", false, true,   7,          0},
+      {"standard", "file",   false, true,   7,          1},
+      {"standard", "stream", true,  true,   10,         0},
+      {"standard", "file",   true,  true,   10,         0},
+      {"light",    "stream", false, true,   7,          0},
+      {"light",    "file",   false, true,   7,          1},
+      {"light",    "stream", true,  true,   10,         0},
+      {"light",    "file",   true,  true,   10,         0},
+      {"custom",   "stream", false, true,   7,          0},
+      {"custom",   "file",   false, true,   7,          1},
+      {"custom",   "stream", true,  true,   10,         0},
+      {"custom",   "file",   true,  true,   10,         0},
+      {"standard", "file",   false, false,  0,          0},
+      {"standard", "file",   true,  false,  0,          0},
+  };
+  // clang-format on
+
+  bool kept = true;
+  for (const Budget &budget : budgets) {
+    kept = check(budget, verbose) && kept;
+  }
+  std::remove(budgetFile);
+
+  if (LOGS_BUDGET_COUNT_ALLOCATIONS == 0) {
+    std::cout << "allocations are not counted in this build" << std::endl;
+  }
+  return kept ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,302 @@
+// logs_replay.cpp
+/**\file
+ * Benchmark, which replays trace captured by `logs::TraceRecorder` against
+ * configuration of logger, so the configuration can be checked with real
+ * logging workload.
+ *
+ * ```
+ * logs_replay [--config logs.ini] [--speed 1] [--profile] app.trace
+ * ```
+ *
+ * - `--config` - configuration of logger, \see LogsConfig.hpp. By default
+ * records are formatted by standard frontend and dropped
+ * - `--speed` - multiplier of speed of trace, `0` means as fast as possible
+ * - `--profile` - print report of `logs::Profiler` for call sites of trace
+ *
+ * Every thread of trace is replayed in own thread. Arguments are replaced by
+ * values of same kind and printed size
+ */
+
+#include <algorithm>
+#include <config/LogsConfig.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <simple_logs/Profiler.hpp>
+#include <simple_logs/Trace.hpp>
+#include <simple_logs/logs.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+/// value of argument, which is printed by `logs::formatter`
+struct FormattedValue {
+  std::string text;
+};
+
+/// value of argument, which is printed by `operator<<`
+struct StreamedValue {
+  std::string text;
+};
+
+std::ostream &operator<<(std::ostream &stream, const StreamedValue &value) {
+  return stream << value.text;
+}
+} // namespace
+
+template <>
+struct logs::formatter<FormattedValue> {
+  static void format(const FormattedValue &value, std::string &out) {
+    out += value.text;
+  }
+};
+
+namespace {
+/**\brief values of arguments with same kind and printed size as in trace
+ */
+class ArgumentPool {
+public:
+  logs::detail::Argument get(const logs::TraceArgument &argument) {
+    std::unique_ptr<Value> &value = values_[{argument.kind, argument.size}];
+    if (value == nullptr) {
+      value = std::make_unique<Value>(argument.size);
+    }
+
+    switch (argument.kind) {
+    case logs::detail::ArgumentKind::Builtin:
+      return logs::detail::makeArgument(value->number);
+    case logs::detail::ArgumentKind::Text:
+      return logs::detail::makeArgument(value->text);
+    case logs::detail::ArgumentKind::Pointer:
+      return logs::detail::makeArgument(value->pointer);
+    case logs::detail::ArgumentKind::Formatted:
+      return logs::detail::makeArgument(value->formatted);
+    case logs::detail::ArgumentKind::Streamed:
+      return logs::detail::makeArgument(value->streamed);
+    }
+    return logs::detail::makeArgument(value->text);
+  }
+
+private:
+  struct Value {
+    explicit Value(std::uint32_t size)
+        : text(size, 'x')
+        , number{1}
+        , pointer{&number}
+        , formatted{text}
+        , streamed{text} {
+      // number with same count of digits
+      for (std::uint32_t i = 1; i < std::min<std::uint32_t>(size, 18); ++i) {
+        number *= 10;
+      }
+    }
+
+    std::string      text;
+    long long        number;
+    const long long *pointer;
+    FormattedValue   formatted;
+    StreamedValue    streamed;
+  };
+
+  std::map<std::pair<logs::detail::ArgumentKind, std::uint32_t>,
+           std::unique_ptr<Value>>
+      values_;
+};
+
+/**\brief drops all records
+ */
+class NullBackend final : public logs::BasicBackend {
+public:
+  void consume(std::string_view) noexcept override {
+  }
+};
+
+struct ReplayEvent {
+  logs::CallSite                     *site;
+  std::string_view                    messageFormat;
+  logs::Severity                      severity;
+  std::chrono::nanoseconds            time;
+  std::vector<logs::detail::Argument> arguments;
+};
+
+/**\brief trace, which is prepared for replaying
+ */
+struct Replay {
+  /// call sites are registered in Profiler until end of program, so they
+  /// and their names and formats are never deleted
+  std::vector<const logs::TraceSite *>  traceSites;
+  std::vector<logs::CallSite *>         callSites;
+  ArgumentPool                          argumentPool;
+  /// events of every thread of trace
+  std::vector<std::vector<ReplayEvent>> threads;
+  std::size_t                           count = 0;
+  std::chrono::nanoseconds              duration{0};
+};
+
+void readTrace(const std::string &fileName, Replay &replay) noexcept(false) {
+  logs::TraceReader reader{fileName};
+  logs::TraceEvent  event;
+  while (reader.next(event)) {
+    const std::vector<logs::TraceSite> &sites = reader.getSites();
+    for (std::size_t i = replay.traceSites.size(); i < sites.size(); ++i) {
+      const logs::TraceSite *site = new logs::TraceSite{sites[i]};
+      replay.traceSites.emplace_back(site);
+      replay.callSites.emplace_back(new logs::CallSite{site->fileName,
+                                                       site->lineNumber,
+                                                       site->functionName});
+    }
+
+    if (event.thread >= replay.threads.size()) {
+      replay.threads.resize(event.thread + 1);
+    }
+    ReplayEvent &replayEvent = replay.threads[event.thread].emplace_back();
+    replayEvent.site          = replay.callSites[event.site];
+    replayEvent.messageFormat = replay.traceSites[event.site]->messageFormat;
+    replayEvent.severity      = event.severity;
+    replayEvent.time          = event.time;
+    for (const logs::TraceArgument &argument : event.arguments) {
+      replayEvent.arguments.emplace_back(replay.argumentPool.get(argument));
+    }
+
+    ++replay.count;
+    replay.duration = event.time;
+  }
+}
+
+/**\return latencies of logging calls
+ */
+std::vector<std::chrono::nanoseconds>
+replayThread(const std::vector<ReplayEvent> &events,
+             Clock::time_point               start,
+             double                          speed) noexcept {
+  std::vector<std::chrono::nanoseconds> latencies;
+  latencies.reserve(events.size());
+  for (const ReplayEvent &event : events) {
+    if (speed > 0) {
+      std::this_thread::sleep_until(
+          start + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      event.time / speed));
+    }
+
+    Clock::time_point begin = Clock::now();
+    logs::detail::logArguments(*event.site,
+                               event.severity,
+                               event.messageFormat,
+                               event.arguments.data(),
+                               event.arguments.size());
+    latencies.emplace_back(Clock::now() - begin);
+  }
+  return latencies;
+}
+
+double toMilliseconds(std::chrono::nanoseconds time) {
+  return std::chrono::duration<double, std::milli>{time}.count();
+}
+
+void printUsage() {
+  std::cerr << "usage: logs_replay [--config file] [--speed factor] "
+               "[--profile] trace"
+            << std::endl;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string configFile;
+  std::string traceFile;
+  double      speed   = 1;
+  bool        profile = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--config" && i + 1 < argc) {
+      configFile = argv[++i];
+    } else if (arg == "--speed" && i + 1 < argc) {
+      speed = std::atof(argv[++i]);
+    } else if (arg == "--profile") {
+      profile = true;
+    } else if (traceFile.empty() && arg.substr(0, 2) != "--") {
+      traceFile = arg;
+    } else {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+  if (traceFile.empty()) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  Replay             replay;
+  logs::ConfigLoader loader;
+  try {
+    readTrace(traceFile, replay);
+
+    if (configFile.empty()) {
+      LOGGER_ADD_SINK(std::make_shared<logs::StandardFrontend>(),
+                      std::make_shared<NullBackend>());
+    } else {
+      loader.load(configFile);
+    }
+  } catch (std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (profile) {
+    logs::Profiler::get().start();
+  }
+
+  std::vector<std::vector<std::chrono::nanoseconds>> latencies(
+      replay.threads.size());
+  std::vector<std::thread> threads;
+  Clock::time_point        start = Clock::now();
+  for (std::size_t i = 0; i < replay.threads.size(); ++i) {
+    threads.emplace_back([&replay, &latencies, i, start, speed]() {
+      latencies[i] = replayThread(replay.threads[i], start, speed);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  Clock::time_point finish = Clock::now();
+  LOGGER.flush();
+  Clock::time_point flushed = Clock::now();
+
+  std::vector<std::chrono::nanoseconds> all;
+  all.reserve(replay.count);
+  for (const std::vector<std::chrono::nanoseconds> &thread : latencies) {
+    all.insert(all.end(), thread.begin(), thread.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double value) {
+    return all.empty()
+               ? 0
+               : all[static_cast<std::size_t>((all.size() - 1) * value)]
+                     .count();
+  };
+  std::chrono::nanoseconds total{0};
+  for (std::chrono::nanoseconds latency : all) {
+    total += latency;
+  }
+
+  std::cout << "records      " << replay.count << std::endl
+            << "threads      " << replay.threads.size() << std::endl
+            << "call sites   " << replay.callSites.size() << std::endl
+            << "trace ms     " << toMilliseconds(replay.duration) << std::endl
+            << "replay ms    " << toMilliseconds(finish - start) << std::endl
+            << "flush ms     " << toMilliseconds(flushed - finish) << std::endl
+            << "latency ns   mean "
+            << (all.empty() ? 0 : total.count() / all.size()) << "  p50 "
+            << percentile(0.5) << "  p99 " << percentile(0.99) << "  p99.9 "
+            << percentile(0.999) << "  max " << percentile(1) << std::endl;
+
+  if (profile) {
+    std::cout << std::endl;
+    logs::Profiler::get().report(std::cout);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,409 @@
+// logs_stress.cpp
+/**\file
+ * Stress test of logger. Several threads log sequence-numbered records
+ * through every backend and mode of logger, then checker reads the written
+ * records and verifies that nothing is lost, duplicated or torn, and that
+ * records of every thread are written in order of logging. Context of request
+ * is checked with concurrent handlers, which are wrapped by one carrier.
+ *
+ * ```
+ * logs_stress [--threads 8] [--records 10000]
+ * ```
+ *
+ * Build it in Debug with `thread_check` or `leak_check` option for running
+ * under sanitizers. Known benign race of libstdc++ is suppressed by
+ * `TSAN_OPTIONS=suppressions=tools/tsan.supp`, ctest sets it. Program fails
+ * if some check is failed
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <simple_logs/IsolatedBackend.hpp>
+#include <simple_logs/RequestBuffer.hpp>
+#include <simple_logs/RequestContext.hpp>
+#include <simple_logs/logs.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+/// records contain only message, other items are checked by other tools
+constexpr std::string_view stressLayout =
+    SEVERITY " " MESSAGE_PREFIX " " MESSAGE;
+
+/// size of file for rotation
+constexpr std::size_t rotationSize = 256 * 1024;
+
+/// maximal count of printed errors for every backend
+constexpr std::size_t maxErrors = 5;
+
+using SeverityOf = std::function<logs::Severity(std::size_t record)>;
+
+/**\brief payload of record, so torn records can be found
+ */
+std::string makePayload(std::size_t thread, std::size_t record) {
+  return std::string(record % 61 + 1, 'a' + (thread + record) % 26);
+}
+
+/**\brief keeps records in memory
+ */
+class CollectingBackend final : public logs::BasicBackend {
+public:
+  void consume(std::string_view record) noexcept override {
+    std::lock_guard<std::mutex> lock{mutex_};
+    records_.emplace_back(record);
+  }
+
+  std::size_t size() noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return records_.size();
+  }
+
+  std::vector<std::string> takeRecords() noexcept {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return std::move(records_);
+  }
+
+private:
+  std::mutex               mutex_;
+  std::vector<std::string> records_;
+};
+
+std::vector<std::string> readLines(std::istream &stream) {
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(stream, line);) {
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+/**\return records of the file and its rotated files in order of writing
+ */
+std::vector<std::string> readFiles(const std::string &fileName,
+                                   std::size_t        maxFiles) {
+  std::vector<std::string> records;
+  for (std::size_t i = maxFiles; i > 0; --i) {
+    std::ifstream file{fileName + '.' + std::to_string(i)};
+    for (std::string &line : readLines(file)) {
+      records.emplace_back(std::move(line));
+    }
+  }
+  std::ifstream file{fileName};
+  for (std::string &line : readLines(file)) {
+    records.emplace_back(std::move(line));
+  }
+  return records;
+}
+
+class Stress {
+public:
+  Stress(std::size_t threads, std::size_t records)
+      : threads_{threads}
+      , records_{records}
+      , directory_{std::filesystem::temp_directory_path() /
+                   ("logs_stress." + std::to_string(getpid()))}
+      , failed_{false} {
+    std::filesystem::create_directories(directory_);
+  }
+
+  ~Stress() {
+    std::error_code error;
+    std::filesystem::remove_all(directory_, error);
+  }
+
+  /**\return path of new file in temporary directory
+   */
+  std::string makeFileName(std::string_view name) const {
+    return (directory_ / name).string();
+  }
+
+  /**\brief log records from all threads and wait until they are written
+   */
+  void log(const SeverityOf &severityOf) const {
+    std::vector<std::thread> threads;
+    for (std::size_t thread = 0; thread < threads_; ++thread) {
+      threads.emplace_back([this, thread, &severityOf]() {
+        logRecords(thread, severityOf);
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    LOGGER.flush();
+  }
+
+  /**\brief log records of every two threads by two concurrent handlers of
+   * one request, which are wrapped by its carrier. Buffer of the request isn't
+   * carried, so records of handlers are written directly
+   */
+  void logCarried() const {
+    std::vector<std::thread> requests;
+    for (std::size_t first = 0; first < threads_; first += 2) {
+      requests.emplace_back([this, first]() {
+        logs::RequestContext context{"request " + std::to_string(first)};
+        logs::RequestScope   scope{context};
+        logs::RequestBuffer  buffer;
+        logs::ContextCarrier carrier;
+
+        std::vector<std::thread> handlers;
+        for (std::size_t thread = first;
+             thread < threads_ && thread < first + 2;
+             ++thread) {
+          handlers.emplace_back(carrier.wrap([this, thread, &context]() {
+            // records are lost, if the handler has wrong state
+            if (logs::RequestScope::current() == &context &&
+                logs::RequestBuffer::current() == nullptr) {
+              logRecords(thread, [](std::size_t) {
+                return logs::Severity::Info;
+              });
+            }
+          }));
+        }
+        for (std::thread &handler : handlers) {
+          handler.join();
+        }
+      });
+    }
+    for (std::thread &request : requests) {
+      request.join();
+    }
+    LOGGER.flush();
+  }
+
+  /**\brief check records of one backend and print result
+   * \param dropped count of records, which were dropped by backend
+   */
+  void check(std::string_view                name,
+             const std::vector<std::string> &records,
+             std::uint64_t                   dropped = 0) {
+    std::vector<std::size_t> next(threads_, 0);
+    std::vector<std::string> errors;
+    std::size_t              lost = 0;
+    for (const std::string &record : records) {
+      std::size_t thread  = 0;
+      std::size_t number  = 0;
+      std::string payload = "invalid";
+
+      std::size_t separator = record.find(" | ");
+      if (separator != std::string::npos) {
+        std::istringstream message{record.substr(separator + 3)};
+        std::string        threadLabel, recordLabel, payloadLabel;
+        message >> threadLabel >> thread >> recordLabel >> number >>
+            payloadLabel >> payload;
+      }
+      if (thread >= threads_ || number >= records_ ||
+          payload != makePayload(thread, number)) {
+        errors.emplace_back("torn record: " + record);
+        continue;
+      }
+
+      if (number < next[thread]) {
+        errors.emplace_back("duplicated or reordered record: " + record);
+        continue;
+      }
+      lost += number - next[thread];
+      next[thread] = number + 1;
+    }
+    for (std::size_t position : next) {
+      lost += records_ - position;
+    }
+    if (lost > dropped) {
+      errors.emplace_back("lost " + std::to_string(lost - dropped) +
+                          " records");
+    }
+
+    std::cout << name << ": " << records.size() << " records";
+    if (dropped != 0) {
+      std::cout << ", " << dropped << " dropped";
+    }
+    std::cout << (errors.empty() ? ", ok" : ", FAILED") << std::endl;
+    for (std::size_t i = 0; i < errors.size() && i < maxErrors; ++i) {
+      std::cout << "  " << errors[i] << std::endl;
+    }
+    failed_ = failed_ || errors.empty() == false;
+  }
+
+  /**\return count of files, which is enough for keeping all records
+   */
+  std::size_t getMaxFiles() const noexcept {
+    // record is shorter than 128 bytes
+    return threads_ * records_ * 128 / rotationSize + 2;
+  }
+
+  std::size_t getTotal() const noexcept {
+    return threads_ * records_;
+  }
+
+  bool isFailed() const noexcept {
+    return failed_;
+  }
+
+private:
+  void logRecords(std::size_t thread, const SeverityOf &severityOf) const {
+    for (std::size_t record = 0; record < records_; ++record) {
+      LOG_MESSAGE(severityOf(record),
+                  "thread %1% record %2% payload %3%",
+                  thread,
+                  record,
+                  makePayload(thread, record));
+    }
+  }
+
+private:
+  std::size_t           threads_;
+  std::size_t           records_;
+  std::filesystem::path directory_;
+  bool                  failed_;
+};
+
+std::shared_ptr<logs::BasicFrontend> makeFrontend() {
+  return std::make_shared<logs::CustomFrontend>(stressLayout);
+}
+
+logs::Severity info(std::size_t) {
+  return logs::Severity::Info;
+}
+
+void checkStream(Stress &stress) {
+  std::ostringstream stream;
+  LOGGER.setSinks({logs::Sink{
+      makeFrontend(), std::make_shared<logs::TextStreamBackend>(stream)}});
+  stress.log(info);
+  LOGGER.setSinks({});
+
+  std::istringstream records{stream.str()};
+  stress.check("sync stream", readLines(records));
+}
+
+void checkFile(Stress &stress, std::string_view name, bool rotation) {
+  std::string fileName = stress.makeFileName(name);
+  std::size_t maxFiles = rotation ? stress.getMaxFiles() : 0;
+  LOGGER.setSinks({logs::Sink{
+      makeFrontend(),
+      std::make_shared<logs::FileBackend>(
+          fileName, rotation ? rotationSize : 0, maxFiles)}});
+  stress.log(info);
+  LOGGER.setSinks({});
+
+  stress.check(name, readFiles(fileName, maxFiles));
+}
+
+void checkAsync(Stress             &stress,
+                std::string_view    name,
+                logs::AsyncSettings settings,
+                const SeverityOf   &severityOf) {
+  std::string fileName = stress.makeFileName(name);
+  LOGGER.setSinks({logs::Sink{makeFrontend(),
+                              std::make_shared<logs::FileBackend>(fileName)}});
+  LOGGER.setAsync(settings);
+  stress.log(severityOf);
+  LOGGER.setSync();
+  LOGGER.setSinks({});
+
+  stress.check(name, readFiles(fileName, 0));
+}
+
+void checkFanOut(Stress &stress) {
+  std::string fileName   = stress.makeFileName("async fan-out file");
+  auto        collecting = std::make_shared<CollectingBackend>();
+  LOGGER.setSinks(
+      {logs::Sink{makeFrontend(),
+                  std::make_shared<logs::FileBackend>(
+                      fileName, rotationSize, stress.getMaxFiles())},
+       logs::Sink{makeFrontend(), collecting}});
+  logs::AsyncSettings settings;
+  settings.fanOutThreads = 2;
+  LOGGER.setAsync(settings);
+  stress.log(info);
+  LOGGER.setSync();
+  LOGGER.setSinks({});
+
+  stress.check("async fan-out file with rotation",
+               readFiles(fileName, stress.getMaxFiles()));
+  stress.check("async fan-out collecting", collecting->takeRecords());
+}
+
+void checkCarried(Stress &stress) {
+  auto collecting = std::make_shared<CollectingBackend>();
+  LOGGER.setSinks({logs::Sink{makeFrontend(), collecting}});
+  LOGGER.setAsync(logs::AsyncSettings{});
+  stress.logCarried();
+  LOGGER.setSync();
+  LOGGER.setSinks({});
+
+  stress.check("async carried context", collecting->takeRecords());
+}
+
+void checkIsolated(Stress &stress) {
+  auto collecting = std::make_shared<CollectingBackend>();
+  logs::IsolationSettings isolation;
+  isolation.queueSize = stress.getTotal();
+  auto isolated =
+      std::make_shared<logs::IsolatedBackend>(collecting, isolation);
+  LOGGER.setSinks({logs::Sink{makeFrontend(), isolated}});
+  LOGGER.setAsync(logs::AsyncSettings{});
+  stress.log(info);
+  LOGGER.setSync();
+  LOGGER.setSinks({});
+
+  // isolated backend writes records in own thread
+  for (int i = 0; i < 1000 && collecting->size() + isolated->getDropped() <
+                                  stress.getTotal();
+       ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+  stress.check("async isolated",
+               collecting->takeRecords(),
+               isolated->getDropped());
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::size_t threads = 8;
+  std::size_t records = 10000;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) {
+      threads = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--records" && i + 1 < argc) {
+      records = std::strtoul(argv[++i], nullptr, 10);
+    } else {
+      std::cerr << "usage: logs_stress [--threads count] [--records count]"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  Stress stress{threads, records};
+  checkStream(stress);
+  checkFile(stress, "sync file", false);
+  checkFile(stress, "sync file with rotation", true);
+  checkAsync(stress, "async file", logs::AsyncSettings{}, info);
+
+  // every 7th record is urgent, so it is written before other records
+  // without keeping of order
+  logs::AsyncSettings ordered;
+  ordered.keepOrder = true;
+  checkAsync(stress, "async ordered urgent", ordered, [](std::size_t record) {
+    return record % 7 == 0 ? logs::Severity::Warning : logs::Severity::Info;
+  });
+
+  // every 13th record is written synchronously after queued records
+  logs::AsyncSettings hybrid;
+  hybrid.synchronous = logs::Severity::Placeholder >= logs::Severity::Error;
+  checkAsync(stress, "async hybrid", hybrid, [](std::size_t record) {
+    return record % 13 == 0 ? logs::Severity::Error : logs::Severity::Info;
+  });
+
+  checkFanOut(stress);
+  checkIsolated(stress);
+  checkCarried(stress);
+
+  return stress.isFailed() ? EXIT_FAILURE : EXIT_SUCCESS;
+}